@@ -0,0 +1,1319 @@
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define BENCH_FILE "benchbuffer.bin"
+
+// bench methods
+static void benchPinUnpin (void);
+static void benchStorageBackends (void);
+static void benchAsyncReads (void);
+static void benchVectoredScan (void);
+static void benchFileExtension (void);
+static void benchPageSizes (void);
+static void benchFrameMemory (void);
+static void benchStrategies (void);
+static void benchConcurrent (void);
+static void benchHotReads (void);
+static void benchWriter (void);
+static void benchPrefetch (void);
+static void benchScanRing (void);
+static void benchBatchPins (void);
+static void benchFlushPool (void);
+static void benchDirtyList (void);
+static void benchPageAccess (void);
+
+// helper methods
+static double nowNs (void);
+static unsigned int nextRandom (unsigned int *seed);
+static void createBenchFile (int numPages);
+static int nextHotColdPage (unsigned int *seed, int filePages);
+static double *initZipf (int filePages, double theta);
+static int nextZipfPage (unsigned int *seed, const double *cdf, int filePages);
+static int nextTracePage (int trace, int op, unsigned int *seed, int *scanPage,
+                          const double *cdf, int filePages);
+
+// the benchmarks by name, all of them run when none is given
+typedef struct benchmark {
+    const char *name;
+    void (*run) (void);
+} benchmark;
+
+static const benchmark benchmarks[] = {
+    {"pin", benchPinUnpin},
+    {"backends", benchStorageBackends},
+    {"async", benchAsyncReads},
+    {"vectored", benchVectoredScan},
+    {"extend", benchFileExtension},
+    {"pagesize", benchPageSizes},
+    {"memory", benchFrameMemory},
+    {"strategies", benchStrategies},
+    {"concurrent", benchConcurrent},
+    {"hotreads", benchHotReads},
+    {"writer", benchWriter},
+    {"prefetch", benchPrefetch},
+    {"scanring", benchScanRing},
+    {"batch", benchBatchPins},
+    {"flush", benchFlushPool},
+    {"dirty", benchDirtyList},
+    {"access", benchPageAccess},
+};
+static const int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+// main method
+int
+main (int argc, char *argv[])
+{
+    int i;
+
+    initStorageManager();
+    for (i = 0; i < numBenchmarks; i++)
+        if (argc < 2 || strcmp(argv[1], benchmarks[i].name) == 0)
+        {
+            printf("== %s ==\n", benchmarks[i].name);
+            benchmarks[i].run();
+        }
+    return 0;
+}
+
+// current time in nanoseconds
+double
+nowNs (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// a small linear congruential generator so every run uses the same trace
+unsigned int
+nextRandom (unsigned int *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+// 80% of the requests go to the first 20% of the file
+int
+nextHotColdPage (unsigned int *seed, int filePages)
+{
+    int hotPages = filePages / 5;
+
+    if (nextRandom(seed) % 100 < 80)
+        return nextRandom(seed) % hotPages;
+    return hotPages + nextRandom(seed) % (filePages - hotPages);
+}
+
+// the cumulative distribution of a Zipf distribution over filePages ranks
+double *
+initZipf (int filePages, double theta)
+{
+    double *cdf = malloc(filePages * sizeof(double));
+    double sum = 0;
+    int i;
+
+    for (i = 0; i < filePages; i++)
+        sum += 1.0 / pow(i + 1, theta);
+    cdf[0] = 1.0 / sum;
+    for (i = 1; i < filePages; i++)
+        cdf[i] = cdf[i - 1] + 1.0 / pow(i + 1, theta) / sum;
+    return cdf;
+}
+
+// draw a rank from the Zipf distribution and scatter the ranks over the file
+int
+nextZipfPage (unsigned int *seed, const double *cdf, int filePages)
+{
+    double u = (nextRandom(seed) & 0xffffff) / (double) 0x1000000;
+    int low = 0, high = filePages - 1;
+
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (cdf[mid] < u)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return (int) ((long long) low * 7919 % filePages);
+}
+
+// the op-th page of a trace of benchStrategies:
+// 0 uniform, 1 80/20, 2 zipf,
+// 3 and 4 a 2000 page scan in every 10000 pins, lookups 80/20 or zipf otherwise,
+// 5 phases of 100000 pins, a scan over the whole file and zipf lookups in turn
+int
+nextTracePage (int trace, int op, unsigned int *seed, int *scanPage,
+               const double *cdf, int filePages)
+{
+    switch (trace)
+    {
+    case 0:
+        return (int) (nextRandom(seed) % filePages);
+    case 1:
+        return nextHotColdPage(seed, filePages);
+    case 2:
+        return nextZipfPage(seed, cdf, filePages);
+    case 3:
+    case 4:
+        if (op % 10000 < 2000)
+            return (*scanPage)++ % filePages;
+        return trace == 3 ? nextHotColdPage(seed, filePages) : nextZipfPage(seed, cdf, filePages);
+    default:
+        if (op / 100000 % 2 == 0)
+            return (*scanPage)++ % filePages;
+        return nextZipfPage(seed, cdf, filePages);
+    }
+}
+
+// create a page file with numPages written pages, so reads are not served from holes
+void
+createBenchFile (int numPages)
+{
+    SM_FileHandle fh;
+    SM_PageHandle buffers[64];
+    char *pages = calloc(64, PAGE_SIZE);
+    int i;
+
+    for (i = 0; i < 64; i++)
+        buffers[i] = pages + i * PAGE_SIZE;
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(numPages, &fh));
+    for (i = 0; i < numPages; i += 64)
+        CHECK(writeBlocks(i, numPages - i < 64 ? numPages - i : 64, &fh, buffers));
+    CHECK(closePageFile(&fh));
+    free(pages);
+}
+
+// cost of a pin/unpin pair on a page which is already in the pool,
+// for pools from 3 to 100000 frames
+void
+benchPinUnpin (void)
+{
+    const int poolSizes[] = {3, 100, 1000, 10000, 100000};
+    const int numPoolSizes = 5;
+    const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+    const char *strategyNames[] = {"FIFO", "LRU", "CLOCK", "LFU", "LRU-2", "ARC", "2Q"};
+    const int numOps = 2000000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int i, j, s;
+
+    createBenchFile(poolSizes[numPoolSizes - 1]);
+
+    printf("%-8s %10s %14s\n", "strategy", "frames", "ns/pin+unpin");
+    for (s = 0; s < 7; s++)
+        for (i = 0; i < numPoolSizes; i++)
+        {
+            int frames = poolSizes[i];
+            unsigned int seed = 42;
+            double start, elapsed;
+
+            CHECK(initBufferPool(bm, BENCH_FILE, frames, strategies[s], NULL));
+            for (j = 0; j < frames; j++)
+            {
+                CHECK(pinPage(bm, h, j));
+                CHECK(unpinPage(bm, h));
+            }
+
+            start = nowNs();
+            for (j = 0; j < numOps; j++)
+            {
+                CHECK(pinPage(bm, h, nextRandom(&seed) % frames));
+                CHECK(unpinPage(bm, h));
+            }
+            elapsed = nowNs() - start;
+
+            printf("%-8s %10d %14.1f\n", strategyNames[s], frames, elapsed / numOps);
+            CHECK(shutdownBufferPool(bm));
+        }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// random page reads and a miss-heavy buffer pool workload on every storage backend
+void
+benchStorageBackends (void)
+{
+    const int backends[] = {SM_OPEN_DEFAULT, SM_OPEN_MMAP, SM_OPEN_DIRECT};
+    const char *backendNames[] = {"pread", "mmap", "direct"};
+    const int numBackends = 3;
+    const int filePages = 20000;
+    const int numReads = 50000;
+    const int numPins = 50000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    SM_FileHandle fh;
+    void *buf;
+    int b, j;
+
+    if (posix_memalign(&buf, SM_DIRECT_IO_ALIGN, PAGE_SIZE) != 0)
+        exit(1);
+    createBenchFile(filePages);
+
+    printf("%-8s %14s %14s\n", "backend", "ns/readBlock", "ns/pinPage");
+    for (b = 0; b < numBackends; b++)
+    {
+        unsigned int seed = 7;
+        double start, readNs, pinNs;
+
+        CHECK(openPageFileWithFlags(BENCH_FILE, &fh, backends[b]));
+        start = nowNs();
+        for (j = 0; j < numReads; j++)
+            CHECK(readBlock(nextRandom(&seed) % filePages, &fh, buf));
+        readNs = (nowNs() - start) / numReads;
+        CHECK(closePageFile(&fh));
+
+        memset(&options, 0, sizeof(options));
+        options.openFlags = backends[b];
+        CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, 1000, RS_LRU, NULL, &options));
+        start = nowNs();
+        for (j = 0; j < numPins; j++)
+        {
+            CHECK(pinPage(bm, h, nextRandom(&seed) % filePages));
+            if (j % 4 == 0)
+                CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+        pinNs = (nowNs() - start) / numPins;
+        CHECK(shutdownBufferPool(bm));
+
+        printf("%-8s %14.1f %14.1f\n", backendNames[b], readNs, pinNs);
+        fflush(stdout);
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(buf);
+    free(bm);
+    free(h);
+}
+
+// random direct I/O reads over a large file: synchronous readBlock at queue depth 1
+// against the asynchronous engine at queue depth 32
+void
+benchAsyncReads (void)
+{
+    const int engines[] = {SM_ASYNC_DEFAULT, SM_ASYNC_THREADS};
+    const char *engineNames[] = {"io_uring", "threads"};
+    const int filePages = 50000;
+    const int numReads = 20000;
+    const int queueDepth = 32;
+    SM_FileHandle fh;
+    SM_AsyncIO *aio;
+    SM_Completion completions[32];
+    char *freeBuffers[32];
+    int numFree;
+    void *buffers;
+    unsigned int seed = 11;
+    double start;
+    int e, j, n, submitted, reaped;
+    RC rc;
+
+    if (posix_memalign(&buffers, SM_DIRECT_IO_ALIGN, queueDepth * PAGE_SIZE) != 0)
+        exit(1);
+    createBenchFile(filePages);
+    rc = openPageFileWithFlags(BENCH_FILE, &fh, SM_OPEN_DIRECT);
+    if (rc == RC_DIRECT_IO_FAILED)
+        rc = openPageFile(BENCH_FILE, &fh);
+    CHECK(rc);
+
+    printf("%-16s %6s %12s %12s\n", "engine", "depth", "ns/read", "reads/s");
+
+    start = nowNs();
+    for (j = 0; j < numReads; j++)
+        CHECK(readBlock(nextRandom(&seed) % filePages, &fh, buffers));
+    printf("%-16s %6d %12.1f %12.0f\n", "readBlock", 1, (nowNs() - start) / numReads,
+           numReads / ((nowNs() - start) / 1e9));
+    fflush(stdout);
+
+    for (e = 0; e < 2; e++)
+    {
+        CHECK(initAsyncIO(&fh, queueDepth, engines[e], &aio));
+        for (numFree = 0; numFree < queueDepth; numFree++)
+            freeBuffers[numFree] = (char *) buffers + numFree * PAGE_SIZE;
+        submitted = reaped = 0;
+        start = nowNs();
+        while (reaped < numReads)
+        {
+            // keep the queue full, each outstanding read owns one buffer
+            for (; submitted < numReads && numFree > 0; submitted++)
+                CHECK(submitReadBlock(aio, nextRandom(&seed) % filePages, freeBuffers[--numFree], NULL));
+            CHECK(reapCompletions(aio, completions, queueDepth, 1, &n));
+            for (j = 0; j < n; j++)
+            {
+                CHECK(completions[j].status);
+                freeBuffers[numFree++] = completions[j].memPage;
+            }
+            reaped += n;
+        }
+        printf("%-16s %6d %12.1f %12.0f\n", engineNames[e], queueDepth, (nowNs() - start) / numReads,
+               numReads / ((nowNs() - start) / 1e9));
+        fflush(stdout);
+        CHECK(shutdownAsyncIO(aio));
+    }
+
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(buffers);
+}
+
+// a sequential scan with readNextBlock against readBlocks runs of 8 to 128 pages
+void
+benchVectoredScan (void)
+{
+    const int runLengths[] = {8, 32, 128};
+    const int filePages = 20000;
+    const int rounds = 5;
+    SM_FileHandle fh;
+    SM_PageHandle buffers[128];
+    char *pages = malloc(128 * PAGE_SIZE);
+    double start;
+    int r, i, j, k;
+
+    for (i = 0; i < 128; i++)
+        buffers[i] = pages + i * PAGE_SIZE;
+    createBenchFile(filePages);
+    CHECK(openPageFile(BENCH_FILE, &fh));
+
+    printf("%-16s %12s\n", "scan", "ns/page");
+    start = nowNs();
+    for (r = 0; r < rounds; r++)
+    {
+        CHECK(readFirstBlock(&fh, pages));
+        for (i = 1; i < filePages; i++)
+            CHECK(readNextBlock(&fh, pages));
+    }
+    printf("%-16s %12.1f\n", "readNextBlock", (nowNs() - start) / (rounds * filePages));
+
+    for (k = 0; k < 3; k++)
+    {
+        char name[32];
+
+        start = nowNs();
+        for (r = 0; r < rounds; r++)
+            for (i = 0; i < filePages; i += runLengths[k])
+            {
+                j = filePages - i < runLengths[k] ? filePages - i : runLengths[k];
+                CHECK(readBlocks(i, j, &fh, buffers));
+            }
+        sprintf(name, "readBlocks(%d)", runLengths[k]);
+        printf("%-16s %12.1f\n", name, (nowNs() - start) / (rounds * filePages));
+    }
+
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(pages);
+}
+
+// appendEmptyBlock one page at a time, without and with an extent growth policy,
+// and a single ensureCapacity to a large file
+void
+benchFileExtension (void)
+{
+    const int policies[][2] = {{0, 0}, {12, 0}, {0, 256}};
+    const char *policyNames[] = {"none", "12%", "1MB"};
+    const int numAppends = 20000;
+    const int bigPages = 1 << 20;
+    SM_FileHandle fh;
+    double start;
+    int p, j;
+
+    printf("%-16s %12s\n", "policy", "ns/append");
+    for (p = 0; p < 3; p++)
+    {
+        CHECK(createPageFile(BENCH_FILE));
+        CHECK(openPageFile(BENCH_FILE, &fh));
+        CHECK(setExtentGrowth(&fh, policies[p][0], policies[p][1]));
+        start = nowNs();
+        for (j = 0; j < numAppends; j++)
+            CHECK(appendEmptyBlock(&fh));
+        printf("%-16s %12.1f\n", policyNames[p], (nowNs() - start) / numAppends);
+        fflush(stdout);
+        CHECK(closePageFile(&fh));
+        CHECK(destroyPageFile(BENCH_FILE));
+    }
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    start = nowNs();
+    CHECK(ensureCapacity(bigPages, &fh));
+    printf("ensureCapacity(%d pages) %.1f us\n", bigPages, (nowNs() - start) / 1e3);
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+// a full scan and random lookups through a pool over the same 64MB of data
+// stored in 4KB, 16KB and 64KB pages
+void
+benchPageSizes (void)
+{
+    const int pageSizes[] = {4096, 16384, 65536};
+    const long long dataBytes = 64LL << 20;
+    const int numLookups = 20000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    double start, scanNs, lookupNs;
+    int p, j, numPages;
+
+    printf("%-10s %10s %14s %14s\n", "pageSize", "reads", "ms/scan", "ns/lookup");
+    for (p = 0; p < 3; p++)
+    {
+        unsigned int seed = 5;
+        int reads;
+
+        numPages = (int) (dataBytes / pageSizes[p]);
+        CHECK(createPageFileWithPageSize(BENCH_FILE, pageSizes[p]));
+        CHECK(openPageFile(BENCH_FILE, &fh));
+        CHECK(ensureCapacity(numPages, &fh));
+        CHECK(closePageFile(&fh));
+
+        CHECK(initBufferPool(bm, BENCH_FILE, 64, RS_LRU, NULL));
+        start = nowNs();
+        for (j = 0; j < numPages; j++)
+        {
+            CHECK(pinPage(bm, h, j));
+            CHECK(unpinPage(bm, h));
+        }
+        scanNs = nowNs() - start;
+        reads = getNumReadIO(bm);
+
+        // lookups of one small record anywhere in the data
+        start = nowNs();
+        for (j = 0; j < numLookups; j++)
+        {
+            CHECK(pinPage(bm, h, (int) ((nextRandom(&seed) % (dataBytes / 128)) * 128 / pageSizes[p])));
+            CHECK(unpinPage(bm, h));
+        }
+        lookupNs = (nowNs() - start) / numLookups;
+        CHECK(shutdownBufferPool(bm));
+
+        printf("%-10d %10d %14.1f %14.1f\n", pageSizes[p], reads, scanNs / 1e6, lookupNs);
+        fflush(stdout);
+        CHECK(destroyPageFile(BENCH_FILE));
+    }
+
+    free(bm);
+    free(h);
+}
+
+// pool startup and teardown, and pin/unpin with every frame in use, for a
+// 100000 frame pool on normal pages and on huge pages
+void
+benchFrameMemory (void)
+{
+    const int memoryFlags[] = {BM_MEM_DEFAULT, BM_MEM_HUGEPAGES};
+    const char *memoryNames[] = {"default", "hugepages"};
+    const int frames = 100000;
+    const int numOps = 2000000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    double start, initUs, pinNs, shutdownUs;
+    int m, j;
+
+    createBenchFile(frames);
+
+    printf("%-10s %10s %14s %12s\n", "memory", "init us", "ns/pin+unpin", "shutdown us");
+    for (m = 0; m < 2; m++)
+    {
+        unsigned int seed = 42;
+
+        memset(&options, 0, sizeof(options));
+        options.memoryFlags = memoryFlags[m];
+        start = nowNs();
+        CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, RS_LRU, NULL, &options));
+        initUs = (nowNs() - start) / 1e3;
+        for (j = 0; j < frames; j++)
+        {
+            CHECK(pinPage(bm, h, j));
+            CHECK(unpinPage(bm, h));
+        }
+
+        start = nowNs();
+        for (j = 0; j < numOps; j++)
+        {
+            CHECK(pinPage(bm, h, nextRandom(&seed) % frames));
+            // touch the page like a reader would
+            h->data[nextRandom(&seed) % PAGE_SIZE]++;
+            CHECK(unpinPage(bm, h));
+        }
+        pinNs = (nowNs() - start) / numOps;
+
+        start = nowNs();
+        CHECK(shutdownBufferPool(bm));
+        shutdownUs = (nowNs() - start) / 1e3;
+        printf("%-10s %10.1f %14.1f %12.1f\n", memoryNames[m], initUs, pinNs, shutdownUs);
+        fflush(stdout);
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// hit ratio and cost of a pin/unpin pair, misses included, of every strategy
+// on a 1000 frame pool over 20000 pages, see nextTracePage for the traces
+void
+benchStrategies (void)
+{
+    const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LFU, RS_LRU_K,
+                                              RS_ARC, RS_2Q};
+    const char *strategyNames[] = {"FIFO", "LRU", "CLOCK", "LFU", "LFU/aged", "LRU-2", "ARC", "2Q"};
+    const int numStrategies = 8;
+    const char *traceNames[] = {"uniform", "80/20", "zipf", "scan+80/20", "scan+zipf", "phases"};
+    const int numTraces = 6;
+    const int filePages = 20000;
+    const int frames = 1000;
+    const int numOps = 500000;
+    int agingPeriod = 10 * frames;
+    int k = 2;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    double *zipf = initZipf(filePages, 0.99);
+    int s, t, j;
+
+    createBenchFile(filePages);
+
+    printf("%-10s %-9s %10s %12s\n", "trace", "strategy", "hit ratio", "ns/pin");
+    for (t = 0; t < numTraces; t++)
+        for (s = 0; s < numStrategies; s++)
+        {
+            unsigned int seed = 3;
+            int scanPage = 0;
+            double start, elapsed;
+
+            CHECK(initBufferPool(bm, BENCH_FILE, frames, strategies[s],
+                                 strategies[s] == RS_LRU_K ? &k : s == 4 ? &agingPeriod : NULL));
+            start = nowNs();
+            for (j = 0; j < numOps; j++)
+            {
+                int pageNum = nextTracePage(t, j, &seed, &scanPage, zipf, filePages);
+
+                CHECK(pinPage(bm, h, pageNum));
+                CHECK(unpinPage(bm, h));
+            }
+            elapsed = nowNs() - start;
+
+            printf("%-10s %-9s %10.3f %12.1f\n", traceNames[t], strategyNames[s],
+                   1.0 - (double) getNumReadIO(bm) / numOps, elapsed / numOps);
+            fflush(stdout);
+            CHECK(shutdownBufferPool(bm));
+        }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(zipf);
+    free(bm);
+    free(h);
+}
+
+// the work of a thread of benchConcurrent
+typedef struct concurrentWork {
+    BM_BufferPool *bm;
+    pthread_mutex_t *poolMutex;     // taken around every call, NULL for a concurrent pool
+    unsigned int seed;
+    int numOps;
+    int numPages;                   // pages of the uniform trace, 0 for the 80/20 one
+    int filePages;
+} concurrentWork;
+
+static void *
+runConcurrentWork (void *arg)
+{
+    concurrentWork *work = (concurrentWork *) arg;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int j;
+
+    for (j = 0; j < work->numOps; j++)
+    {
+        int pageNum = work->numPages > 0 ? (int) (nextRandom(&work->seed) % work->numPages)
+                    : nextHotColdPage(&work->seed, work->filePages);
+
+        if (work->poolMutex)
+            pthread_mutex_lock(work->poolMutex);
+        CHECK(pinPage(work->bm, h, pageNum));
+        if (work->poolMutex)
+        {
+            pthread_mutex_unlock(work->poolMutex);
+            pthread_mutex_lock(work->poolMutex);
+        }
+        CHECK(unpinPage(work->bm, h));
+        if (work->poolMutex)
+            pthread_mutex_unlock(work->poolMutex);
+    }
+    free(h);
+    return NULL;
+}
+
+// aggregate pin/unpin throughput of 1 to 16 threads sharing a pool of 1000
+// frames: a pool for one thread behind a global mutex against a concurrent
+// pool with 64 latch partitions, on hits only (1000 pages) and on an 80/20
+// trace over 10000 pages
+void
+benchConcurrent (void)
+{
+    const int threadCounts[] = {1, 2, 4, 8, 16};
+    const int numThreadCounts = 5;
+    const ReplacementStrategy strategies[] = {RS_CLOCK, RS_LRU};
+    const char *strategyNames[] = {"CLOCK", "LRU"};
+    const char *modeNames[] = {"mutex", "latched"};
+    const int frames = 1000;
+    const int filePages = 10000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_t threads[16];
+    concurrentWork work[16];
+    int s, m, trace, t, i;
+
+    createBenchFile(filePages);
+
+    printf("%ld online CPUs\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-6s %-8s %-8s %8s %12s\n", "trace", "strategy", "pool", "threads", "Mpins/s");
+    for (trace = 0; trace < 2; trace++)
+        for (s = 0; s < 2; s++)
+            for (m = 0; m < 2; m++)
+                for (t = 0; t < numThreadCounts; t++)
+                {
+                    int numThreads = threadCounts[t];
+                    int totalOps = trace == 0 ? 4000000 : 200000;
+                    double start, elapsed;
+
+                    memset(&options, 0, sizeof(options));
+                    options.latchPartitions = m == 1 ? 64 : 0;
+                    CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, strategies[s], NULL, &options));
+                    for (i = 0; i < frames; i++)
+                    {
+                        CHECK(pinPage(bm, h, i));
+                        CHECK(unpinPage(bm, h));
+                    }
+
+                    start = nowNs();
+                    for (i = 0; i < numThreads; i++)
+                    {
+                        work[i].bm = bm;
+                        work[i].poolMutex = m == 0 ? &poolMutex : NULL;
+                        work[i].seed = i + 1;
+                        work[i].numOps = totalOps / numThreads;
+                        work[i].numPages = trace == 0 ? frames : 0;
+                        work[i].filePages = filePages;
+                        pthread_create(&threads[i], NULL, runConcurrentWork, &work[i]);
+                    }
+                    for (i = 0; i < numThreads; i++)
+                        pthread_join(threads[i], NULL);
+                    elapsed = nowNs() - start;
+
+                    printf("%-6s %-8s %-8s %8d %12.2f\n", trace == 0 ? "hits" : "80/20",
+                           strategyNames[s], modeNames[m], numThreads, totalOps / elapsed * 1e3);
+                    fflush(stdout);
+                    CHECK(shutdownBufferPool(bm));
+                }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// the work of a thread of benchHotReads
+typedef struct hotReadWork {
+    BM_BufferPool *bm;
+    bool optimistic;
+    int numOps;
+    int numPages;
+    long sum;                       // of the bytes read, so the reads are not optimized away
+} hotReadWork;
+
+static void *
+runHotReads (void *arg)
+{
+    hotReadWork *work = (hotReadWork *) arg;
+    BM_PageHandle *handles[4];
+    int i, j, b;
+
+    for (i = 0; i < work->numPages; i++)
+    {
+        handles[i] = MAKE_PAGE_HANDLE();
+        handles[i]->data = NULL;
+    }
+    for (j = 0; j < work->numOps; j++)
+    {
+        BM_PageHandle *h = handles[j % work->numPages];
+        long sum;
+
+        if (work->optimistic)
+        {
+            unsigned int version;
+
+            do
+            {
+                CHECK(beginOptimisticRead(work->bm, h, j % work->numPages, &version));
+                for (sum = 0, b = 0; b < 64; b++)
+                    sum += h->data[b];
+            } while (validateOptimisticRead(work->bm, h, version) != RC_OK);
+        }
+        else
+        {
+            CHECK(pinPageWithMode(work->bm, h, j % work->numPages, PIN_SHARED));
+            for (sum = 0, b = 0; b < 64; b++)
+                sum += h->data[b];
+            CHECK(unpinPageWithMode(work->bm, h, PIN_SHARED));
+        }
+        work->sum += sum;
+    }
+    for (i = 0; i < work->numPages; i++)
+        free(handles[i]);
+    return NULL;
+}
+
+// aggregate read throughput of 1 to 16 threads reading the same 4 hot pages
+// (like the root and inner pages of an index): pinned under a shared latch,
+// which writes the fix count and the latch word of every page it reads,
+// against optimistic reads validated by the page version
+void
+benchHotReads (void)
+{
+    const int threadCounts[] = {1, 2, 4, 8, 16};
+    const int numThreadCounts = 5;
+    const char *modeNames[] = {"shared", "optimistic"};
+    const int totalOps = 4000000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    pthread_t threads[16];
+    hotReadWork work[16];
+    int m, t, i;
+
+    createBenchFile(4);
+
+    printf("%ld online CPUs\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-10s %8s %12s\n", "read", "threads", "Mreads/s");
+    for (m = 0; m < 2; m++)
+        for (t = 0; t < numThreadCounts; t++)
+        {
+            int numThreads = threadCounts[t];
+            double start, elapsed;
+
+            memset(&options, 0, sizeof(options));
+            options.latchPartitions = 64;
+            CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, 16, RS_CLOCK, NULL, &options));
+            for (i = 0; i < 4; i++)
+            {
+                CHECK(pinPage(bm, h, i));
+                CHECK(unpinPage(bm, h));
+            }
+
+            start = nowNs();
+            for (i = 0; i < numThreads; i++)
+            {
+                work[i].bm = bm;
+                work[i].optimistic = m == 1;
+                work[i].numOps = totalOps / numThreads;
+                work[i].numPages = 4;
+                work[i].sum = 0;
+                pthread_create(&threads[i], NULL, runHotReads, &work[i]);
+            }
+            for (i = 0; i < numThreads; i++)
+                pthread_join(threads[i], NULL);
+            elapsed = nowNs() - start;
+
+            printf("%-10s %8d %12.2f\n", modeNames[m], numThreads, totalOps / elapsed * 1e3);
+            fflush(stdout);
+            CHECK(shutdownBufferPool(bm));
+        }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// misses on a pool where a third of the pins dirty their page (80/20 trace
+// over 20000 pages, 1000 frames), without a background writer and with one
+// keeping 5, 10 or 25 percent of the next victims clean: the time of a pin,
+// the misses which still wrote their victim and the pages the writer wrote
+void
+benchWriter (void)
+{
+    const int cleanPercents[] = {0, 5, 10, 25};
+    const int numSettings = 4;
+    const int filePages = 20000;
+    const int frames = 1000;
+    const int numOps = 200000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    BM_WriterStats stats;
+    int c, j;
+
+    createBenchFile(filePages);
+
+    printf("%-8s %10s %16s %14s %12s\n", "clean %", "ns/pin", "dirty evictions", "writer pages", "pages/s");
+    for (c = 0; c < numSettings; c++)
+    {
+        unsigned int seed = 11;
+        double start, elapsed;
+
+        memset(&options, 0, sizeof(options));
+        options.cleanPercent = cleanPercents[c];
+        options.writerIntervalMs = 1;
+        CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, RS_CLOCK, NULL, &options));
+        start = nowNs();
+        for (j = 0; j < numOps; j++)
+        {
+            CHECK(pinPage(bm, h, nextHotColdPage(&seed, filePages)));
+            if (j % 3 == 0)
+            {
+                h->data[0]++;
+                CHECK(markDirty(bm, h));
+            }
+            CHECK(unpinPage(bm, h));
+        }
+        elapsed = nowNs() - start;
+        CHECK(getWriterStats(bm, &stats));
+
+        printf("%-8d %10.1f %16d %14d %12.0f\n", cleanPercents[c], elapsed / numOps,
+               stats.dirtyEvictions, stats.pagesWritten, stats.pagesPerSecond);
+        fflush(stdout);
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// a scan of 20000 pages through 1000 frames, and random probes of an index
+// like range scan (runs of 16 pages at random places), each with the next
+// pages prefetched 0, 8 or 32 pages ahead, through the page cache and with
+// direct I/O
+void
+benchPrefetch (void)
+{
+    const int backends[] = {SM_OPEN_DEFAULT, SM_OPEN_DIRECT};
+    const char *backendNames[] = {"default", "direct"};
+    const int distances[] = {0, 8, 32};
+    const char *patternNames[] = {"scan", "runs"};
+    const int filePages = 20000;
+    const int frames = 1000;
+    const int numOps = 20000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    BM_PrefetchStats stats;
+    PageNumber ahead[32];
+    int b, d, pattern, j;
+
+    createBenchFile(filePages);
+
+    printf("%-8s %-5s %9s %10s %10s %8s\n", "backend", "scan", "distance", "ns/pin", "used", "unused");
+    for (b = 0; b < 2; b++)
+        for (pattern = 0; pattern < 2; pattern++)
+            for (d = 0; d < 3; d++)
+            {
+                unsigned int seed = 5;
+                int runStart = 0;
+                int next = 0;
+                double start, elapsed;
+
+                memset(&options, 0, sizeof(options));
+                options.openFlags = backends[b];
+                options.prefetchDepth = 64;
+                CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, RS_CLOCK, NULL, &options));
+                start = nowNs();
+                for (j = 0; j < numOps; j++)
+                {
+                    int pageNum, limit;
+
+                    if (pattern == 1 && j % 16 == 0)
+                    {
+                        runStart = nextRandom(&seed) % (filePages - 16);
+                        next = runStart;
+                    }
+                    pageNum = pattern == 0 ? j : runStart + j % 16;
+                    limit = pattern == 0 ? filePages : runStart + 16;
+                    // refill the window once half of it is used
+                    if (distances[d] > 0 && next <= pageNum + distances[d] / 2)
+                    {
+                        int n = 0;
+
+                        if (next <= pageNum)
+                            next = pageNum + 1;
+                        while (next <= pageNum + distances[d] && next < limit)
+                            ahead[n++] = next++;
+                        if (n > 0)
+                            CHECK(prefetchPages(bm, ahead, n));
+                    }
+                    CHECK(pinPage(bm, h, pageNum));
+                    CHECK(unpinPage(bm, h));
+                }
+                elapsed = nowNs() - start;
+                CHECK(getPrefetchStats(bm, &stats));
+
+                printf("%-8s %-5s %9d %10.1f %10d %8d\n", backendNames[b], patternNames[pattern],
+                       distances[d], elapsed / numOps, stats.used, stats.unused);
+                fflush(stdout);
+                CHECK(shutdownBufferPool(bm));
+            }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// an OLTP load (80/20 over the first 2000 pages) on 1000 frames, with a
+// scan of 20000 other pages after every 5000 of its pins: the hit ratio of
+// the OLTP pins when the scans use the whole pool, when the pool detects
+// them (after 32 misses on consecutive pages) and when they use a ring
+void
+benchScanRing (void)
+{
+    const ReplacementStrategy strategies[] = {RS_LRU, RS_CLOCK, RS_2Q};
+    const char *strategyNames[] = {"LRU", "CLOCK", "2Q"};
+    const char *modeNames[] = {"pool", "detected", "ring"};
+    const int filePages = 30000;
+    const int frames = 1000;
+    const int rounds = 10;
+    const int oltpOps = 5000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    BM_ScanRing *ring;
+    int s, m, r, j;
+
+    createBenchFile(filePages);
+
+    printf("%-8s %-9s %14s %12s\n", "strategy", "scans", "OLTP hits", "ns/scan pin");
+    for (s = 0; s < 3; s++)
+        for (m = 0; m < 3; m++)
+        {
+            unsigned int seed = 9;
+            int oltpReads = 0;
+            double scanNs = 0;
+
+            memset(&options, 0, sizeof(options));
+            options.scanThreshold = m == 1 ? 32 : 0;
+            CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, strategies[s], NULL, &options));
+            for (r = 0; r < rounds; r++)
+            {
+                int reads = getNumReadIO(bm);
+                double start;
+
+                for (j = 0; j < oltpOps; j++)
+                {
+                    CHECK(pinPage(bm, h, nextHotColdPage(&seed, 2000)));
+                    CHECK(unpinPage(bm, h));
+                }
+                // the first round warms the pool up
+                if (r > 0)
+                    oltpReads += getNumReadIO(bm) - reads;
+
+                start = nowNs();
+                ring = NULL;
+                if (m == 2)
+                    CHECK(initScanRing(bm, 16, &ring));
+                for (j = 10000; j < filePages; j++)
+                {
+                    if (ring)
+                    {
+                        CHECK(pinPageWithRing(bm, ring, h, j));
+                    }
+                    else
+                    {
+                        CHECK(pinPage(bm, h, j));
+                    }
+                    CHECK(unpinPage(bm, h));
+                }
+                freeScanRing(ring);
+                scanNs += nowNs() - start;
+            }
+
+            printf("%-8s %-9s %14.3f %12.1f\n", strategyNames[s], modeNames[m],
+                   1.0 - (double) oltpReads / ((rounds - 1) * oltpOps), scanNs / (rounds * (filePages - 10000)));
+            fflush(stdout);
+            CHECK(shutdownBufferPool(bm));
+        }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// batches of 32 pins on 1000 frames, pinned with a loop of pinPage or with
+// one pinPages: runs of consecutive pages (misses read with one vectored
+// read per batch), random pages of a 20000 page file (misses, mostly
+// isolated) and random pages of the first 500 (hits), through the page
+// cache and with direct I/O
+void
+benchBatchPins (void)
+{
+    const int backends[] = {SM_OPEN_DEFAULT, SM_OPEN_DIRECT};
+    const char *backendNames[] = {"default", "direct"};
+    const char *patternNames[] = {"runs", "random", "hits"};
+    const char *modeNames[] = {"pinPage", "pinPages"};
+    const int filePages = 20000;
+    const int frames = 1000;
+    const int batchSize = 32;
+    const int numBatches = 1000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *handles = malloc(batchSize * sizeof(BM_PageHandle));
+    PageNumber *pageNums = malloc(batchSize * sizeof(PageNumber));
+    int b, pattern, m, j, k;
+
+    createBenchFile(filePages);
+
+    printf("%-8s %-7s %-9s %10s %10s\n", "backend", "pages", "pins", "ns/pin", "reads");
+    for (b = 0; b < 2; b++)
+        for (pattern = 0; pattern < 3; pattern++)
+            for (m = 0; m < 2; m++)
+            {
+                unsigned int seed = 13;
+                BM_PoolOptions options;
+                double start, elapsed;
+
+                memset(&options, 0, sizeof(options));
+                options.openFlags = backends[b];
+                CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, RS_LRU, NULL, &options));
+                if (pattern == 2)
+                {
+                    for (j = 0; j < 500; j++)
+                    {
+                        CHECK(pinPage(bm, handles, j));
+                        CHECK(unpinPage(bm, handles));
+                    }
+                }
+                start = nowNs();
+                for (j = 0; j < numBatches; j++)
+                {
+                    int runStart = nextRandom(&seed) % (filePages - batchSize);
+
+                    for (k = 0; k < batchSize; k++)
+                    {
+                        if (pattern == 0)
+                            pageNums[k] = runStart + k;
+                        else
+                            pageNums[k] = nextRandom(&seed) % (pattern == 1 ? filePages : 500);
+                    }
+                    if (m == 1)
+                    {
+                        CHECK(pinPages(bm, handles, pageNums, batchSize));
+                        CHECK(unpinPages(bm, handles, batchSize));
+                        continue;
+                    }
+                    for (k = 0; k < batchSize; k++)
+                        CHECK(pinPage(bm, &handles[k], pageNums[k]));
+                    for (k = 0; k < batchSize; k++)
+                        CHECK(unpinPage(bm, &handles[k]));
+                }
+                elapsed = nowNs() - start;
+
+                printf("%-8s %-7s %-9s %10.1f %10d\n", backendNames[b], patternNames[pattern], modeNames[m],
+                       elapsed / (numBatches * batchSize), getNumReadIO(bm));
+                fflush(stdout);
+                CHECK(shutdownBufferPool(bm));
+            }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(handles);
+    free(pageNums);
+}
+
+// time to flush 10000 frames full of dirty pages, loaded in random order:
+// pages 0-9999 of the file (dense) or 10000 random pages of 40000 (sparse),
+// written one page per frame in frame order with forcePage, or with
+// forceFlushPool on 1 or 4 threads, through the page cache and with direct I/O
+void
+benchFlushPool (void)
+{
+    const int backends[] = {SM_OPEN_DEFAULT, SM_OPEN_DIRECT};
+    const char *backendNames[] = {"default", "direct"};
+    const char *patternNames[] = {"dense", "sparse"};
+    const char *modeNames[] = {"forcePage", "flush x1", "flush x4"};
+    const int filePages = 40000;
+    const int frames = 10000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    PageNumber *pageNums = malloc(filePages * sizeof(PageNumber));
+    int b, pattern, m, j;
+
+    createBenchFile(filePages);
+
+    printf("%-8s %-7s %-10s %10s %10s\n", "backend", "pages", "flush", "ms", "writes");
+    for (b = 0; b < 2; b++)
+        for (pattern = 0; pattern < 2; pattern++)
+            for (m = 0; m < 3; m++)
+            {
+                unsigned int seed = 17;
+                BM_PoolOptions options;
+                PageNumber *frameContents;
+                double start, elapsed;
+
+                // a random permutation of the first 10000 pages or of the whole
+                // file, its first 10000 pages are dirtied
+                int n = pattern == 0 ? frames : filePages;
+
+                for (j = 0; j < n; j++)
+                    pageNums[j] = j;
+                for (j = n - 1; j > 0; j--)
+                {
+                    int k = nextRandom(&seed) % (j + 1);
+                    PageNumber swap = pageNums[j];
+
+                    pageNums[j] = pageNums[k];
+                    pageNums[k] = swap;
+                }
+
+                memset(&options, 0, sizeof(options));
+                options.openFlags = backends[b];
+                options.flushThreads = m == 2 ? 4 : 1;
+                CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, frames, RS_LRU, NULL, &options));
+                for (j = 0; j < frames; j++)
+                {
+                    CHECK(pinPage(bm, h, pageNums[j]));
+                    h->data[0]++;
+                    CHECK(markDirty(bm, h));
+                    CHECK(unpinPage(bm, h));
+                }
+
+                start = nowNs();
+                if (m == 0)
+                {
+                    frameContents = getFrameContents(bm);
+                    for (j = 0; j < frames; j++)
+                    {
+                        h->pageNum = frameContents[j];
+                        CHECK(forcePage(bm, h));
+                    }
+                }
+                else
+                    CHECK(forceFlushPool(bm));
+                elapsed = nowNs() - start;
+
+                printf("%-8s %-7s %-10s %10.1f %10d\n", backendNames[b], patternNames[pattern], modeNames[m],
+                       elapsed / 1e6, getNumWriteIO(bm));
+                fflush(stdout);
+                CHECK(shutdownBufferPool(bm));
+            }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+    free(pageNums);
+}
+
+// checkpoints of a 100000 frame pool with 0 to 1000 dirty pages, written
+// through the page cache: a checkpoint costs the writes of the dirty pages,
+// not a visit of every frame
+void
+benchDirtyList (void)
+{
+    const int dirtyCounts[] = {0, 10, 100, 1000};
+    const int frames = 100000;
+    const int rounds = 20;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_DirtyStats stats;
+    int d, r, j;
+
+    createBenchFile(frames);
+
+    printf("%-8s %14s %16s\n", "dirty", "us/flush", "us/dirty page");
+    CHECK(initBufferPool(bm, BENCH_FILE, frames, RS_CLOCK, NULL));
+    for (j = 0; j < frames; j++)
+    {
+        CHECK(pinPage(bm, h, j));
+        CHECK(unpinPage(bm, h));
+    }
+    for (d = 0; d < 4; d++)
+    {
+        unsigned int seed = 21;
+        double flushNs = 0, start;
+        int dirtyPages = 0;
+
+        for (r = 0; r < rounds; r++)
+        {
+            for (j = 0; j < dirtyCounts[d]; j++)
+            {
+                CHECK(pinPage(bm, h, nextRandom(&seed) % frames));
+                CHECK(markDirty(bm, h));
+                CHECK(unpinPage(bm, h));
+            }
+            CHECK(getDirtyStats(bm, &stats));
+            dirtyPages += stats.dirtyPages;
+            start = nowNs();
+            CHECK(forceFlushPool(bm));
+            flushNs += nowNs() - start;
+        }
+        printf("%-8d %14.1f %16.2f\n", dirtyCounts[d], flushNs / rounds / 1e3,
+               dirtyPages > 0 ? flushNs / dirtyPages / 1e3 : 0);
+        fflush(stdout);
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
+
+// the cost of a page access which hits, pin, change a byte, markDirty and
+// unpin, on 1000 and 100000 frames, with one thread and with the pool
+// shared by threads (8 latch partitions)
+void
+benchPageAccess (void)
+{
+    const int poolSizes[] = {1000, 100000};
+    const int numOps = 2000000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    int s, c, j;
+
+    createBenchFile(100000);
+
+    printf("%-8s %-12s %12s\n", "frames", "pool", "ns/access");
+    for (s = 0; s < 2; s++)
+        for (c = 0; c < 2; c++)
+        {
+            unsigned int seed = 25;
+            double start, elapsed;
+
+            memset(&options, 0, sizeof(options));
+            options.latchPartitions = c == 0 ? 0 : 8;
+            CHECK(initBufferPoolWithOptions(bm, BENCH_FILE, poolSizes[s], RS_CLOCK, NULL, &options));
+            for (j = 0; j < poolSizes[s]; j++)
+            {
+                CHECK(pinPage(bm, h, j));
+                CHECK(unpinPage(bm, h));
+            }
+            start = nowNs();
+            for (j = 0; j < numOps; j++)
+            {
+                CHECK(pinPage(bm, h, nextRandom(&seed) % poolSizes[s]));
+                h->data[j % 64]++;
+                CHECK(markDirty(bm, h));
+                CHECK(unpinPage(bm, h));
+            }
+            elapsed = nowNs() - start;
+
+            printf("%-8d %-12s %12.1f\n", poolSizes[s], c == 0 ? "one thread" : "shared",
+                   elapsed / numOps);
+            fflush(stdout);
+            CHECK(shutdownBufferPool(bm));
+        }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+    free(bm);
+    free(h);
+}
@@ -1,22 +1,44 @@
+#ifdef __linux__
+#define _GNU_SOURCE     //for MAP_HUGETLB
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 #include "buffer_mgr.h"
 #include "dberror.h"
 #include "storage_mgr.h"
 
-#define MAX_PAGES 20000
-#define MAX_FRAMES 200
 #define MAX_K 10
+#define HASH_MULTIPLIER 2654435769u
+#define NO_FRAME -1
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define LIST_NONE 0
+#define LIST_RECENT 1
+#define LIST_FREQUENT 2
+#define LOAD_RUN_PAGES 64     //the most pages a miss of pinPages reads with one readBlocks
+#define FLUSH_RUN_PAGES 64    //the most pages forceFlushPool writes with one writeBlocks
+/* the page latch of a frame: reader count and state bits in one word */
+#define LATCH_EXCLUSIVE 0x80000000u
+#define LATCH_WRITER_WAITING 0x40000000u   //new readers hold off
+#define LATCH_SLEEPERS 0x20000000u         //a thread sleeps on the word, wake it on release
+#define LATCH_READERS 0x1fffffffu
 /**
- *  A struct of page frame contain the information of one page of buffer pool
+ *  A node of the replacement list, the metadata of the frame is kept in
+ *  the arrays of bufferInfo under frameNum
  */
 typedef struct frameNode{
-    int pageNum;
     int frameNum;
-    int dirtyMark;
-    int fixCount;
-    char* data;
     struct frameNode *next;
     struct frameNode *previous;
 }frameNode;
@@ -30,39 +52,496 @@ typedef struct queue{
 }queue;
 
 /**
- *  A struct descript the information of buffer pool
+ *  A bucket of the LFU frequency list. It holds the frames referenced count
+ *  times, least recently referenced first; the buckets are linked by
+ *  increasing count.
+ */
+typedef struct lfuBucket{
+    int count;
+    frameNode *head;
+    frameNode *tail;
+    struct lfuBucket *next;
+    struct lfuBucket *previous;
+}lfuBucket;
+
+/**
+ *  An open-addressing hash table which maps a page number to the frame
+ *  holding it. Slots are probed linearly and a key of NO_PAGE marks an
+ *  empty slot. The table doubles when it gets half full.
+ */
+typedef struct pageTable{
+    int capacity;
+    int shift;
+    int size;
+    PageNumber *keys;
+    int *frames;
+}pageTable;
+
+/**
+ *  The state of LRU-K. Every frame keeps the times of its last K references,
+ *  most recent first, and the frames are kept in a heap ordered by the K-th
+ *  most recent reference (the backward K-distance). The histories of evicted
+ *  pages are kept in a bounded ring, found through a page table, so a page
+ *  which comes back soon still has its references.
+ */
+typedef struct lruKInfo{
+    int k;
+    long long clock;            //logical time, one tick per pin
+    long long *history;         //K times per frame
+    int *heap;
+    int *heapPos;               //the heap slot of each frame, -1 if not in the heap
+    int heapSize;
+    int *skipped;               //the pinned frames lruKVictim takes out of the heap
+    pageTable retained;         //evicted page -> ring slot
+    PageNumber *retainedPages;
+    long long *retainedHistory; //K times per ring slot
+    int retainedSize;
+    int retainedNext;
+}lruKInfo;
+
+/**
+ *  A list of the numbers of pages evicted lately (a ghost list), oldest
+ *  first. The entries live in slots linked by index and are found through a
+ *  page table; when the list is full the oldest entry makes room.
+ */
+typedef struct ghostList{
+    int capacity;
+    int size;
+    int head;
+    int tail;
+    int freeSlots;
+    PageNumber *pages;
+    int *next;
+    int *previous;
+    pageTable table;    //page -> slot
+}ghostList;
+
+/**
+ *  The state of ARC and 2Q. Both keep the frames in a recent list (ARC T1,
+ *  2Q A1in) and a frequent list (ARC T2, 2Q Am), least recently used first,
+ *  and remember evicted pages in ghost lists. ARC has a ghost list per
+ *  resident list (B1, B2) and moves target, the size it wants the recent
+ *  list to have, towards the list whose ghosts are hit. 2Q only remembers
+ *  pages evicted from the recent list (A1out) and target is the fixed size
+ *  of the recent list (Kin).
+ */
+typedef struct adaptiveInfo{
+    queue recent;
+    queue frequent;
+    int recentSize;
+    int frequentSize;
+    char *listOf;           //LIST_* of each frame
+    ghostList recentGhosts;
+    ghostList frequentGhosts;
+    int target;
+}adaptiveInfo;
+
+/**
+ *  A struct descript the information of buffer pool. The metadata of the
+ *  frames is stored as one array per field, indexed by frame number and
+ *  sized from numPages, so a scan over one field touches only that field.
+ *  All arrays come from one allocation (metadata) and the page buffers of
+ *  all frames from one mapping (arena), frame i at arena + i * pageSize.
+ *
+ *  A concurrent pool (partitionLatches != NULL) splits the page table into
+ *  partitions, page p in partition p % numPartitions, each guarded by its
+ *  latch; the fix count of a frame only changes under the latch of the
+ *  partition of its page. The replacement state is guarded by
+ *  strategyLatch. A frame is ioBusy while it is written back or loaded and
+ *  no latch is held then; threads which want its page wait for ioDone.
+ *  Lock order: strategyLatch, then one partition latch.
  */
 
 typedef struct bufferInfo{
     int frameNumInBuffer;
     int readTimes;
-    int pageToFrame[MAX_PAGES];
-    int frameToPage[MAX_FRAMES];
     int writeTimes;
+    int pageSize;
     void *stratData;
-    bool dirtyFlags[MAX_FRAMES];
-    int fixedCounts[MAX_FRAMES];
+    PageNumber *frameToPage;
+    bool *dirtyFlags;
+    long long *dirtySince;  //when the page of a dirty frame was first dirtied, in ns
+    int *dirtyNext;         //the dirty frames, first dirtied first
+    int *dirtyPrev;
+    int dirtyHead;
+    int dirtyTail;
+    int numDirty;
+    int *fixedCounts;
+    unsigned int *pageLatches;
+    unsigned int *pageVersions; //odd while the page of a frame is written or loaded
+    unsigned int *frameGenerations; //bumped whenever a frame loses its page
+    bool *refBits;          //CLOCK reference bits
+    bool *ioBusy;
+    bool *prefetched;       //loaded by prefetchPages and not pinned since
+    int clockHand;
+    lfuBucket *lfuBuckets;  //LFU bucket pool, a bucket per frame is enough
+    lfuBucket *lfuFreeBuckets;
+    lfuBucket *lfuLowest;   //LFU bucket with the lowest count
+    lfuBucket **frameBucket;
+    int lfuAgingPeriod;     //LFU halves all counts every lfuAgingPeriod references, 0 = never
+    int lfuReferences;
+    lruKInfo *lruK;
+    adaptiveInfo *adaptive;
+    frameNode *frameNodes;
+    void *metadata;
+    char *arena;
+    size_t arenaSize;
+    pageTable *tables;      //one partition unless the pool is concurrent
+    int numPartitions;
+    pthread_mutex_t *partitionLatches;
+    pthread_mutex_t strategyLatch;
+    pthread_mutex_t ioLatch;
+    pthread_cond_t ioDone;
+    pthread_rwlock_t fileLatch;     //shared for reads and writes, exclusive to extend the file
+    pthread_mutex_t dirtyLatch;     //the dirty list, taken with no other latch after it
+    SM_FileHandle fileHandle;
     queue *frames;
+    int writerWindow;           //frames next in line for eviction the writer keeps clean, 0 = no writer
+    int writerIntervalMs;
+    int *writerCandidates;
+    bool writerStop;
+    pthread_t writer;
+    pthread_mutex_t writerLatch;
+    pthread_cond_t writerWake;
+    struct timespec writerStart;
+    BM_WriterStats writerStats;
+    SM_AsyncIO *prefetchIO;     //started by the first prefetchPages
+    int prefetchDepth;
+    SM_Completion *prefetchCompletions;
+    pthread_mutex_t prefetchLatch;  //the async engine serves one thread at a time
+    BM_PrefetchStats prefetchStats;
+    int scanThreshold;          //misses on consecutive pages before a run goes to scanRing, 0 = never
+    PageNumber lastMiss;
+    int missRun;                //misses on consecutive pages up to lastMiss
+    BM_ScanRing *scanRing;      //the ring of the scans the pool detects
+    int flushThreads;           //threads forceFlushPool writes with
 }bufferInfo;
 
 /**
- *  Initial a new node
+ *  The frames a scan recycles, in the order it loaded pages into them.
+ *  pages remembers what the scan put into each frame, so a frame which the
+ *  pool gave to another page meanwhile is not taken back.
+ */
+struct BM_ScanRing{
+    int size;
+    int next;
+    int *frames;
+    PageNumber *pages;
+};
+
+/**
+ *  The page buffer of a frame
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame number
  *
- *  @return new node
+ *  @return the page buffer
  */
-frameNode *initNode(){
-    frameNode *node = malloc(sizeof(frameNode));
+static char *frameAddress(bufferInfo *info, int frame){
+    return info->arena + (size_t)frame * info->pageSize;
+}
 
-    node->data = calloc(PAGE_SIZE, sizeof(SM_FileHandle));
-    node->frameNum = 0;
-    node->next = NULL;
-    node->previous = NULL;
-    node->pageNum = NO_PAGE;
-    node->dirtyMark = 0;
-    node->fixCount = 0;
-    return node;
+/**
+ *  Whether a frame is pinned. Victims are picked without the partition
+ *  latches, so the fix count is read atomically and checked again by
+ *  claimFrame.
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame number
+ *
+ *  @return TRUE if the fix count is not 0
+ */
+static bool framePinned(bufferInfo *info, int frame){
+    return __atomic_load_n(&(info->fixedCounts)[frame], __ATOMIC_RELAXED) != 0;
+}
+
+/**
+ *  Add to the fix count of a frame, under the latch of the partition of its page
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame number
+ *  @param delta 1 to pin, -1 to unpin
+ */
+static void fixFrame(bufferInfo *info, int frame, int delta){
+    __atomic_fetch_add(&(info->fixedCounts)[frame], delta, __ATOMIC_RELAXED);
+}
+
+/**
+ *  Map the arena which holds the page buffers of all frames. The mapping is
+ *  page aligned, so the buffers can be used for direct I/O, and memory is
+ *  only committed for the frames which are used. BM_MEM_HUGEPAGES asks for
+ *  huge pages (MAP_HUGETLB, or transparent huge pages when none are
+ *  reserved) and BM_MEM_LOCK keeps the arena in memory with mlock.
+ *
+ *  @param info        The information of buffer pool
+ *  @param numFrames   The number of frames
+ *  @param memoryFlags The BM_MEM_* flags
+ *
+ *  @return The status
+ */
+static RC initFrameArena(bufferInfo *info, int numFrames, int memoryFlags){
+    size_t size = (size_t)numFrames * info->pageSize;
+    char *arena = MAP_FAILED;
+
+    if(memoryFlags & BM_MEM_HUGEPAGES){
+        size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+        arena = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    }
+    if(arena == MAP_FAILED){
+        arena = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(arena == MAP_FAILED){
+            return RC_UNESPECTED_ERROR;
+        }
+#ifdef MADV_HUGEPAGE
+        if(memoryFlags & BM_MEM_HUGEPAGES){
+            madvise(arena, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    if((memoryFlags & BM_MEM_LOCK) && mlock(arena, size) != 0){
+        munmap(arena, size);
+        return RC_MEMORY_LOCK_FAILED;
+    }
+    info->arena = arena;
+    info->arenaSize = size;
+    return RC_OK;
+}
+
+/**
+ *  Allocate the metadata arrays of numFrames frames in one block
+ *
+ *  @param info      The information of buffer pool
+ *  @param numFrames The number of frames
+ *
+ *  @return The status
+ */
+static RC initFrameMetadata(bufferInfo *info, int numFrames){
+    //largest alignment first, so every array is aligned for its type
+    size_t nodeBytes = (size_t)numFrames * sizeof(frameNode);
+    size_t timeBytes = (size_t)numFrames * sizeof(long long);
+    size_t intBytes = (size_t)numFrames * sizeof(int);
+    char *block = malloc(nodeBytes + timeBytes + 7 * intBytes + 4 * (size_t)numFrames * sizeof(bool));
+    int i;
+
+    if(block == NULL){
+        return RC_UNESPECTED_ERROR;
+    }
+    info->metadata = block;
+    info->frameNodes = (frameNode *)block;
+    info->dirtySince = (long long *)(block + nodeBytes);
+    block += nodeBytes + timeBytes;
+    info->frameToPage = (PageNumber *)block;
+    info->fixedCounts = (int *)(block + intBytes);
+    info->pageLatches = (unsigned int *)(block + 2 * intBytes);
+    info->pageVersions = (unsigned int *)(block + 3 * intBytes);
+    info->dirtyNext = (int *)(block + 4 * intBytes);
+    info->dirtyPrev = (int *)(block + 5 * intBytes);
+    info->frameGenerations = (unsigned int *)(block + 6 * intBytes);
+    info->dirtyFlags = (bool *)(block + 7 * intBytes);
+    info->refBits = info->dirtyFlags + numFrames;
+    info->ioBusy = info->refBits + numFrames;
+    info->prefetched = info->ioBusy + numFrames;
+    info->clockHand = 0;
+    info->dirtyHead = NO_FRAME;
+    info->dirtyTail = NO_FRAME;
+    info->numDirty = 0;
+
+    for(i = 0; i < numFrames; i++){
+        info->frameNodes[i].frameNum = i;
+        info->frameNodes[i].previous = i > 0 ? &(info->frameNodes[i - 1]) : NULL;
+        info->frameNodes[i].next = i < numFrames - 1 ? &(info->frameNodes[i + 1]) : NULL;
+        info->frameToPage[i] = NO_PAGE;
+        info->fixedCounts[i] = 0;
+        info->pageLatches[i] = 0;
+        info->pageVersions[i] = 0;
+        info->frameGenerations[i] = 0;
+        info->dirtyFlags[i] = FALSE;
+        info->dirtySince[i] = 0;
+        info->dirtyNext[i] = NO_FRAME;
+        info->dirtyPrev[i] = NO_FRAME;
+        info->refBits[i] = FALSE;
+        info->ioBusy[i] = FALSE;
+        info->prefetched[i] = FALSE;
+    }
+    return RC_OK;
+}
+
+
+/**
+ *  Initial the page table with room for at least numFrames pages
+ *
+ *  @param table     The page table
+ *  @param numFrames The number of frames of the buffer pool
+ *
+ *  @return The status
+ */
+static RC initPageTable(pageTable *table, int numFrames){
+    int bits = 1;
+    int i;
+
+    //keep the load factor under one half
+    while((1 << bits) < 2 * numFrames){
+        bits++;
+    }
+    table->capacity = 1 << bits;
+    table->shift = 32 - bits;
+    table->size = 0;
+    table->keys = malloc(table->capacity * sizeof(PageNumber));
+    table->frames = malloc(table->capacity * sizeof(int));
+    if(table->keys == NULL || table->frames == NULL){
+        free(table->keys);
+        free(table->frames);
+        return RC_UNESPECTED_ERROR;
+    }
+    for(i = 0; i < table->capacity; i++){
+        table->keys[i] = NO_PAGE;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Free the memory of the page table
+ *
+ *  @param table The page table
+ */
+static void freePageTable(pageTable *table){
+    free(table->keys);
+    free(table->frames);
+    table->keys = NULL;
+    table->frames = NULL;
+}
+
+/**
+ *  The home slot of a page number
+ *
+ *  @param table   The page table
+ *  @param pageNum The number of page
+ *
+ *  @return The slot
+ */
+static int pageTableSlot(pageTable *table, PageNumber pageNum){
+    return (int)(((unsigned int)pageNum * HASH_MULTIPLIER) >> table->shift);
+}
+
+/**
+ *  Look up the frame of a page number
+ *
+ *  @param table   The page table
+ *  @param pageNum The number of page
+ *
+ *  @return The frame, NO_FRAME if the page is not in the table
+ */
+static int pageTableGet(pageTable *table, PageNumber pageNum){
+    int mask = table->capacity - 1;
+    int slot = pageTableSlot(table, pageNum);
+
+    while(table->keys[slot] != NO_PAGE){
+        if(table->keys[slot] == pageNum){
+            return table->frames[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NO_FRAME;
 }
 
+/**
+ *  Move the entries of the page table into a table twice as large
+ *
+ *  @param table The page table
+ *
+ *  @return The status
+ */
+static RC pageTableGrow(pageTable *table){
+    pageTable larger;
+    int i;
+
+    if(initPageTable(&larger, table->capacity) != RC_OK){
+        return RC_UNESPECTED_ERROR;
+    }
+    for(i = 0; i < table->capacity; i++){
+        if(table->keys[i] != NO_PAGE){
+            int slot = pageTableSlot(&larger, table->keys[i]);
+
+            while(larger.keys[slot] != NO_PAGE){
+                slot = (slot + 1) & (larger.capacity - 1);
+            }
+            larger.keys[slot] = table->keys[i];
+            larger.frames[slot] = table->frames[i];
+        }
+    }
+    larger.size = table->size;
+    freePageTable(table);
+    *table = larger;
+    return RC_OK;
+}
+
+/**
+ *  Map a page number to a frame. The page must not be in the table.
+ *
+ *  @param table   The page table
+ *  @param pageNum The number of page
+ *  @param frame   The frame holding the page
+ *
+ *  @return The status, RC_UNESPECTED_ERROR if the table is full and cannot grow
+ */
+static RC pageTablePut(pageTable *table, PageNumber pageNum, int frame){
+    int mask;
+    int slot;
+
+    //keep the load factor under one half, a full table cannot take the entry
+    if(2 * (table->size + 1) > table->capacity && pageTableGrow(table) != RC_OK
+       && table->size + 1 >= table->capacity){
+        return RC_UNESPECTED_ERROR;
+    }
+    mask = table->capacity - 1;
+    slot = pageTableSlot(table, pageNum);
+    while(table->keys[slot] != NO_PAGE){
+        slot = (slot + 1) & mask;
+    }
+    table->keys[slot] = pageNum;
+    table->frames[slot] = frame;
+    table->size++;
+    return RC_OK;
+}
+
+/**
+ *  Remove a page number from the table. The following slots of the probe
+ *  chain are shifted back so no tombstone is needed.
+ *
+ *  @param table   The page table
+ *  @param pageNum The number of page
+ */
+static void pageTableRemove(pageTable *table, PageNumber pageNum){
+    int mask = table->capacity - 1;
+    int slot = pageTableSlot(table, pageNum);
+    int next;
+
+    while(table->keys[slot] != pageNum){
+        if(table->keys[slot] == NO_PAGE){
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    next = slot;
+    while(1){
+        next = (next + 1) & mask;
+        if(table->keys[next] == NO_PAGE){
+            break;
+        }
+        //move the entry back if its home slot is not between slot and next
+        int home = pageTableSlot(table, table->keys[next]);
+        if(((next - home) & mask) >= ((next - slot) & mask)){
+            table->keys[slot] = table->keys[next];
+            table->frames[slot] = table->frames[next];
+            slot = next;
+        }
+    }
+    table->keys[slot] = NO_PAGE;
+    table->size--;
+}
 
 /**
  *  Update the Tail of list
@@ -77,7 +556,10 @@ void enQueue(queue **list, frameNode *updateNode){
     frameNode *tail = (*list)->tail;
     frameNode *head = (*list)->head;
     
-    if(updateNode == head){
+    if(updateNode == tail){
+        return;
+    }
+    else if(updateNode == head){
 
         frameNode *temp = head->next;
         temp->previous = NULL;
@@ -90,7 +572,7 @@ void enQueue(queue **list, frameNode *updateNode){
         (*list)->tail=updateNode;
         return;
     }
-    else if(updateNode  != tail && updateNode !=head){
+    else{
         
         updateNode->previous->next = updateNode->next;
         updateNode->next->previous = updateNode->previous;
@@ -103,515 +585,3458 @@ void enQueue(queue **list, frameNode *updateNode){
         
         return;
     }
-    else{
-        return;
-    }
 
 }
 
 
 /**
- *  Find the node with given page number
+ *  Set up the page table partitions and, for a concurrent pool, the latches
  *
- *  @param list    queue
- *  @param pageNum The number of page
+ *  @param info          The information of buffer pool
+ *  @param numFrames     The number of frames
+ *  @param numPartitions The number of partitions, 0 for a pool used by one thread
  *
- *  @return NULL
+ *  @return The status
  */
-frameNode *findNodewithPageNum(queue *list, const PageNumber pageNum){
-    frameNode *current = list->head;
-    
-    do {
-        if(current->pageNum == pageNum){
-            return current;
+static RC initPartitions(bufferInfo *info, int numFrames, int numPartitions){
+    int i;
+
+    info->numPartitions = numPartitions > 0 ? numPartitions : 1;
+    info->partitionLatches = NULL;
+    info->tables = calloc(info->numPartitions, sizeof(pageTable));
+    if(info->tables == NULL){
+        return RC_UNESPECTED_ERROR;
+    }
+    //a partition grows when more pages than its share hash to it
+    for(i = 0; i < info->numPartitions; i++){
+        if(initPageTable(&(info->tables[i]), numFrames / info->numPartitions + 1) != RC_OK){
+            return RC_UNESPECTED_ERROR;
         }
-        current = current->next;
-    } while (current != NULL);
-    
-    return NULL;
+    }
+    if(numPartitions > 0){
+        info->partitionLatches = malloc(numPartitions * sizeof(pthread_mutex_t));
+        if(info->partitionLatches == NULL){
+            return RC_UNESPECTED_ERROR;
+        }
+        for(i = 0; i < numPartitions; i++){
+            pthread_mutex_init(&(info->partitionLatches[i]), NULL);
+        }
+        pthread_mutex_init(&(info->strategyLatch), NULL);
+        pthread_mutex_init(&(info->ioLatch), NULL);
+        pthread_cond_init(&(info->ioDone), NULL);
+        pthread_rwlock_init(&(info->fileLatch), NULL);
+        pthread_mutex_init(&(info->dirtyLatch), NULL);
+    }
+    return RC_OK;
 }
+
 /**
- *  Check if the page in memory, if it is, then fixCount add 1.
+ *  Free the page table partitions and the latches
  *
- *  @param buffer
- *  @param page
- *  @param pageNum
- *
- *  @return <#return value description#>
+ *  @param info The information of buffer pool
  */
-frameNode *pageInMemo(BM_BufferPool *const buffer, BM_PageHandle *const page, const PageNumber pageNum){
-    
-    frameNode *found;
-    bufferInfo *info = (bufferInfo *)buffer->mgmtData;
-    
-    found = findNodewithPageNum(info->frames, pageNum);
-    
-    if (found!=NULL) {
-        page->pageNum = pageNum;
-        page->data = found->data;
-        
-        found->fixCount++;
-        
-        return found;
+static void freePartitions(bufferInfo *info){
+    int i;
+
+    if(info->tables != NULL){
+        for(i = 0; i < info->numPartitions; i++){
+            freePageTable(&(info->tables[i]));
+        }
+        free(info->tables);
+        info->tables = NULL;
+    }
+    if(info->partitionLatches != NULL){
+        for(i = 0; i < info->numPartitions; i++){
+            pthread_mutex_destroy(&(info->partitionLatches[i]));
+        }
+        free(info->partitionLatches);
+        info->partitionLatches = NULL;
+        pthread_mutex_destroy(&(info->strategyLatch));
+        pthread_mutex_destroy(&(info->ioLatch));
+        pthread_cond_destroy(&(info->ioDone));
+        pthread_rwlock_destroy(&(info->fileLatch));
+        pthread_mutex_destroy(&(info->dirtyLatch));
     }
-    return NULL;
-    
 }
+
 /**
- *  Update the information of frame node
+ *  The page table partition of a page
  *
- *  @param buffer  An instance of BM_bufferPool
- *  @param found   The frame need to update
- *  @param page    An instence of BM_pageHandle
- *  @param pageNum The page number
+ *  @param info    The information of buffer pool
+ *  @param pageNum The number of page
  *
- *  @return The status
+ *  @return The partition
  */
-RC updateFrame(BM_BufferPool *const buffer, frameNode *found, BM_PageHandle *const page, const PageNumber pageNum){
-    SM_FileHandle fHandle;
-    bufferInfo *info = (bufferInfo *)buffer->mgmtData;
-    
-    RC status;
-    status = openPageFile ((char *)(buffer->pageFile), &fHandle);
-    if (status != RC_OK){
-        return status;
-    }
+static pageTable *partitionOf(bufferInfo *info, PageNumber pageNum){
+    return &(info->tables[(unsigned int)pageNum % info->numPartitions]);
+}
 
-    
-    if(found->dirtyMark ==1){
-        if((status = ensureCapacity(pageNum, &fHandle)) != RC_OK || (status = writeBlock(found->pageNum, &fHandle, found->data))!= RC_OK){
-            return status;
-        }
-        (info->writeTimes)++;
-        (info->readTimes)++;
-    }
-    (info->pageToFrame)[found->pageNum] = NO_PAGE;
-    
-    status = ensureCapacity(pageNum, &fHandle);
-    if(status != RC_OK){
-        return status;
-    }
-    status = readBlock(pageNum, &fHandle, found->data);
-    if(status != RC_OK){
-        return status;
+/**
+ *  Latch the page table partition of a page, a no-op unless the pool is concurrent
+ *
+ *  @param info    The information of buffer pool
+ *  @param pageNum The number of page
+ */
+static void lockPartition(bufferInfo *info, PageNumber pageNum){
+    if(info->partitionLatches != NULL){
+        pthread_mutex_lock(&(info->partitionLatches[(unsigned int)pageNum % info->numPartitions]));
     }
+}
 
+static void unlockPartition(bufferInfo *info, PageNumber pageNum){
+    if(info->partitionLatches != NULL){
+        pthread_mutex_unlock(&(info->partitionLatches[(unsigned int)pageNum % info->numPartitions]));
+    }
+}
 
-    page->pageNum = pageNum;
-    page->data = found->data;
-    
-    (info->readTimes)++;
-    
-
-    found->dirtyMark = 0;
-    found->fixCount = 1;
-    found->pageNum = pageNum;
-    
-    (info->pageToFrame)[found->pageNum] = found->frameNum;
-    (info->frameToPage)[found->frameNum] = found->pageNum;
-    
-    closePageFile(&fHandle);
-    
-    return RC_OK;
-    
+static void lockStrategy(bufferInfo *info){
+    if(info->partitionLatches != NULL){
+        pthread_mutex_lock(&(info->strategyLatch));
+    }
 }
 
+static void unlockStrategy(bufferInfo *info){
+    if(info->partitionLatches != NULL){
+        pthread_mutex_unlock(&(info->strategyLatch));
+    }
+}
 
 /**
- Initial the buffer pool
- 
- - returns: Return the status
+ *  Latch the dirty list, a no-op unless the pool is concurrent
+ *
+ *  @param info The information of buffer pool
  */
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
-                  const int numPages, ReplacementStrategy strategy,
-                  void *stratData)
-{
-    int i;
-    SM_FileHandle fh;
-    bufferInfo *bminfo = malloc(sizeof(bufferInfo));
-    
-    RC status;
-    status = openPageFile ((char *)pageFileName, &fh);
-    if (status != RC_OK){
-        return status;
+static void lockDirty(bufferInfo *info){
+    if(info->partitionLatches != NULL){
+        pthread_mutex_lock(&(info->dirtyLatch));
     }
+}
 
-    
-    bm->numPages = numPages;
-    bm->pageFile = (char*) pageFileName;
-    bm->strategy = strategy;
-    bm->mgmtData = bminfo;
-    
-    bminfo->frameNumInBuffer = 0;
-    bminfo->readTimes = 0;
-    bminfo->writeTimes = 0;
-    bminfo->stratData = stratData;
-    
-    memset(bminfo->frameToPage,NO_PAGE,MAX_FRAMES*sizeof(int));
-    memset(bminfo->pageToFrame,NO_PAGE,MAX_PAGES*sizeof(int));
-    memset(bminfo->dirtyFlags,NO_PAGE,MAX_FRAMES*sizeof(bool));
-    memset(bminfo->fixedCounts,NO_PAGE,MAX_FRAMES*sizeof(int));
-    
-    bminfo->frames = malloc(sizeof(queue));
-    queue *frameList = bminfo->frames;
-    frameList->head = initNode();
-    frameList->tail = initNode();
-    frameList->head = frameList->tail;
-    
-    i = 1;
-
-    while(i<numPages){
-        frameList->tail->next = initNode();
-        frameList->tail->next->previous = frameList->tail;
-        frameList->tail = frameList->tail->next;
-        frameList->tail->frameNum = i;
-        i++;
+static void unlockDirty(bufferInfo *info){
+    if(info->partitionLatches != NULL){
+        pthread_mutex_unlock(&(info->dirtyLatch));
     }
-    
-
-    
-    closePageFile(&fh);
-    
-    return RC_OK;
 }
+
 /**
- *  Shut down the buffer poll
- *
- *  @param bm The point pointer to the buffer pool need to shut down
+ *  The time the dirty list records
  *
- *  @return the status
+ *  @return The monotonic clock in nanoseconds
  */
-RC shutdownBufferPool(BM_BufferPool *const bm)
-{
+static long long monotonicNs(void){
+    struct timespec now;
 
-    if (bm && bm->numPages > 0) {
-        RC status;
-        status = forceFlushPool(bm);
-        if(status != RC_OK){
-            
-            bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
-            queue *frameList=bminfo->frames;
-            frameNode *current = frameList->head;
-            
-            do{
-                current = current->next;
-                free(frameList->head->data);
-                free(frameList->head);
-                frameList->head = current;
-            }while(current != NULL);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ *  Mark the page of a frame dirty. A page which was clean goes to the end
+ *  of the dirty list, dirtied at since.
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ *  @param since When the page was first dirtied, 0 = now
+ */
+static void setDirty(bufferInfo *info, int frame, long long since){
+    //pages are marked dirty far more often than they become dirty
+    if(__atomic_load_n(&(info->dirtyFlags)[frame], __ATOMIC_RELAXED)){
+        return;
+    }
+    if(since == 0){
+        since = monotonicNs();
+    }
+    lockDirty(info);
+    if(!(info->dirtyFlags)[frame]){
+        __atomic_store_n(&(info->dirtyFlags)[frame], TRUE, __ATOMIC_RELAXED);
+        info->dirtySince[frame] = since;
+        info->dirtyPrev[frame] = info->dirtyTail;
+        info->dirtyNext[frame] = NO_FRAME;
+        if(info->dirtyTail != NO_FRAME){
+            info->dirtyNext[info->dirtyTail] = frame;
+        }
+        else{
+            info->dirtyHead = frame;
+        }
+        info->dirtyTail = frame;
+        info->numDirty++;
+    }
+    unlockDirty(info);
+}
+
+/**
+ *  Mark the page of a frame clean and take it off the dirty list
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ *
+ *  @return When the page was first dirtied, 0 if it was clean
+ */
+static long long setClean(bufferInfo *info, int frame){
+    long long since = 0;
+
+    lockDirty(info);
+    if((info->dirtyFlags)[frame]){
+        __atomic_store_n(&(info->dirtyFlags)[frame], FALSE, __ATOMIC_RELAXED);
+        since = info->dirtySince[frame];
+        if(info->dirtyPrev[frame] != NO_FRAME){
+            info->dirtyNext[info->dirtyPrev[frame]] = info->dirtyNext[frame];
+        }
+        else{
+            info->dirtyHead = info->dirtyNext[frame];
+        }
+        if(info->dirtyNext[frame] != NO_FRAME){
+            info->dirtyPrev[info->dirtyNext[frame]] = info->dirtyPrev[frame];
+        }
+        else{
+            info->dirtyTail = info->dirtyPrev[frame];
+        }
+        info->numDirty--;
+    }
+    unlockDirty(info);
+    return since;
+}
+
+/**
+ *  Latch the page file, shared to read or write pages, exclusive to extend it
+ *
+ *  @param info      The information of buffer pool
+ *  @param exclusive Take the latch exclusively
+ */
+static void lockFile(bufferInfo *info, bool exclusive){
+    if(info->partitionLatches != NULL){
+        if(exclusive){
+            pthread_rwlock_wrlock(&(info->fileLatch));
+        }
+        else{
+            pthread_rwlock_rdlock(&(info->fileLatch));
+        }
+    }
+}
+
+static void unlockFile(bufferInfo *info){
+    if(info->partitionLatches != NULL){
+        pthread_rwlock_unlock(&(info->fileLatch));
+    }
+}
+
+/**
+ *  Wait until the I/O of a frame is done
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void waitFrame(bufferInfo *info, int frame){
+    pthread_mutex_lock(&(info->ioLatch));
+    while(__atomic_load_n(&(info->ioBusy[frame]), __ATOMIC_ACQUIRE)){
+        pthread_cond_wait(&(info->ioDone), &(info->ioLatch));
+    }
+    pthread_mutex_unlock(&(info->ioLatch));
+}
+
+/**
+ *  End the I/O of a frame and wake the threads waiting for it
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void releaseFrame(bufferInfo *info, int frame){
+    if(info->partitionLatches == NULL){
+        info->ioBusy[frame] = FALSE;
+        return;
+    }
+    pthread_mutex_lock(&(info->ioLatch));
+    __atomic_store_n(&(info->ioBusy[frame]), FALSE, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&(info->ioDone));
+    pthread_mutex_unlock(&(info->ioLatch));
+}
+
+/**
+ *  Take an unpinned frame picked as victim, unless a prefetch reads into it.
+ *  In a concurrent pool the fix
+ *  count is checked again under the latch of the partition of its page,
+ *  since the victim is picked without it, and the frame is marked ioBusy
+ *  so no thread can pin it any more. Called with strategyLatch held.
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ *
+ *  @return TRUE if the frame can be evicted
+ */
+static bool claimFrame(bufferInfo *info, int frame){
+    PageNumber pageNum;
+    bool claimed;
+
+    //the frames of prefetch reads are busy in every pool
+    if(info->partitionLatches == NULL){
+        return !info->ioBusy[frame];
+    }
+    //the page of a frame only changes while the frame is busy
+    if(__atomic_load_n(&(info->ioBusy[frame]), __ATOMIC_ACQUIRE)){
+        return FALSE;
+    }
+    pageNum = (info->frameToPage)[frame];
+    if(pageNum == NO_PAGE){
+        __atomic_store_n(&(info->ioBusy[frame]), TRUE, __ATOMIC_RELAXED);
+        return TRUE;
+    }
+    lockPartition(info, pageNum);
+    claimed = !framePinned(info, frame);
+    if(claimed){
+        __atomic_store_n(&(info->ioBusy[frame]), TRUE, __ATOMIC_RELAXED);
+    }
+    unlockPartition(info, pageNum);
+    return claimed;
+}
+
+/**
+ *  Start changing the page of a frame: its version becomes odd, so optimistic
+ *  readers of the frame fail until endFrameChange
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void beginFrameChange(bufferInfo *info, int frame){
+    __atomic_fetch_add(&(info->pageVersions[frame]), 1, __ATOMIC_RELAXED);
+    //the version is seen changed before any byte of the page
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ *  Finish changing the page of a frame, its version becomes even again
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void endFrameChange(bufferInfo *info, int frame){
+    __atomic_fetch_add(&(info->pageVersions[frame]), 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  Finish a prefetch read: the page is found in its frame from now on, or
+ *  taken out of the page table again if it could not be read. The frame is
+ *  no longer busy, a prefetch never pins it. Called with prefetchLatch held.
+ *
+ *  @param info       The information of buffer pool
+ *  @param completion The completion of the read
+ */
+static void finishPrefetch(bufferInfo *info, SM_Completion *completion){
+    int frame = (int)(intptr_t)completion->userData;
+    PageNumber pageNum = completion->pageNum;
+
+    if(completion->status == RC_OK){
+        __atomic_fetch_add(&(info->readTimes), 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&(info->frameToPage)[frame], pageNum, __ATOMIC_RELEASE);
+        info->prefetchStats.completed++;
+    }
+    if(completion->status != RC_OK){
+        lockPartition(info, pageNum);
+        pageTableRemove(partitionOf(info, pageNum), pageNum);
+        __atomic_store_n(&(info->prefetched)[frame], FALSE, __ATOMIC_RELAXED);
+        unlockPartition(info, pageNum);
+    }
+    endFrameChange(info, frame);
+    __atomic_fetch_sub(&(info->prefetchStats.inFlight), 1, __ATOMIC_RELAXED);
+    releaseFrame(info, frame);
+}
+
+/**
+ *  Collect the prefetch reads which are done
+ *
+ *  @param info The information of buffer pool
+ *  @param wait Wait until at least one is done, if any is outstanding
+ */
+static void reapPrefetches(bufferInfo *info, bool wait){
+    int n, i;
+
+    pthread_mutex_lock(&(info->prefetchLatch));
+    if(info->prefetchIO != NULL && __atomic_load_n(&(info->prefetchStats.inFlight), __ATOMIC_RELAXED) > 0
+       && reapCompletions(info->prefetchIO, info->prefetchCompletions, info->prefetchDepth,
+                          wait ? 1 : 0, &n) == RC_OK){
+        for(i = 0; i < n; i++){
+            finishPrefetch(info, &(info->prefetchCompletions[i]));
+        }
+    }
+    pthread_mutex_unlock(&(info->prefetchLatch));
+}
+
+/**
+ *  Wait for the outstanding prefetch reads and stop the async engine
+ *
+ *  @param info The information of buffer pool
+ */
+static void stopPrefetch(bufferInfo *info){
+    while(__atomic_load_n(&(info->prefetchStats.inFlight), __ATOMIC_RELAXED) > 0){
+        reapPrefetches(info, TRUE);
+    }
+    pthread_mutex_lock(&(info->prefetchLatch));
+    if(info->prefetchIO != NULL){
+        shutdownAsyncIO(info->prefetchIO);
+        info->prefetchIO = NULL;
+    }
+    free(info->prefetchCompletions);
+    info->prefetchCompletions = NULL;
+    pthread_mutex_unlock(&(info->prefetchLatch));
+}
+
+/**
+ *  Find the frame with given page number. In a concurrent pool the caller
+ *  holds the latch of the partition of the page.
+ *
+ *  @param info    The information of buffer pool
+ *  @param pageNum The number of page
+ *
+ *  @return The frame holding the page, NO_FRAME if the page is not in buffer
+ */
+static int findFramewithPageNum(bufferInfo *info, const PageNumber pageNum){
+    if(pageNum < 0){
+        return NO_FRAME;
+    }
+    return pageTableGet(partitionOf(info, pageNum), pageNum);
+}
+
+/**
+ *  Point a page handle at the frame holding its page
+ *
+ *  @param info    The information of buffer pool
+ *  @param page    The page handle
+ *  @param pageNum The page
+ *  @param frame   The frame holding it
+ */
+static void setHandle(bufferInfo *info, BM_PageHandle *const page, const PageNumber pageNum, int frame){
+    page->pageNum = pageNum;
+    page->data = frameAddress(info, frame);
+    page->frame = frame;
+    page->generation = __atomic_load_n(&(info->frameGenerations)[frame], __ATOMIC_RELAXED);
+}
+
+/**
+ *  The frame holding the page of a handle. A handle set by pinPage goes
+ *  straight to its frame while the frame keeps the page; other handles,
+ *  and handles of a page evicted since, look the page up. Called with the
+ *  partition latch of the page held.
+ *
+ *  @param bm   The buffer pool
+ *  @param page The page handle
+ *
+ *  @return The frame, NO_FRAME if the page is not in buffer
+ */
+static int handleFrame(BM_BufferPool *const bm, BM_PageHandle *const page){
+    bufferInfo *info = (bufferInfo *)bm->mgmtData;
+    int frame = page->frame;
+
+    if(frame >= 0 && frame < bm->numPages
+       && __atomic_load_n(&(info->frameGenerations)[frame], __ATOMIC_RELAXED) == page->generation
+       && __atomic_load_n(&(info->frameToPage)[frame], __ATOMIC_RELAXED) == page->pageNum){
+        return frame;
+    }
+    return findFramewithPageNum(info, page->pageNum);
+}
+/**
+ *  Check if the page in memory, if it is, then fixCount add 1. A page which
+ *  is still being loaded is waited for.
+ *
+ *  @param buffer   An instance of BM_bufferPool
+ *  @param page     An instence of BM_pageHandle
+ *  @param pageNum  The page number
+ *  @param firstUse Set to TRUE if the page was prefetched and this is its first pin
+ *
+ *  @return The frame holding the page, NO_FRAME if the page is not in buffer
+ */
+int pageInMemo(BM_BufferPool *const buffer, BM_PageHandle *const page, const PageNumber pageNum, bool *firstUse){
+    
+    bufferInfo *info = (bufferInfo *)buffer->mgmtData;
+    int found;
+    bool prefetching;
+    
+    *firstUse = FALSE;
+    while(1){
+        lockPartition(info, pageNum);
+        found = findFramewithPageNum(info, pageNum);
+        if(found == NO_FRAME || !__atomic_load_n(&(info->ioBusy[found]), __ATOMIC_ACQUIRE)){
+            break;
+        }
+        prefetching = __atomic_load_n(&(info->prefetched)[found], __ATOMIC_RELAXED);
+        //loaded or evicted by another thread, look again when it is done
+        unlockPartition(info, pageNum);
+        if(prefetching){
+            //nobody waits for the engine, so the threads which want a page collect it
+            reapPrefetches(info, TRUE);
+        }
+        else{
+            waitFrame(info, found);
+        }
+    }
+    
+    if (found != NO_FRAME) {
+        setHandle(info, page, pageNum, found);
+        
+        fixFrame(info, found, 1);
+        if(__atomic_load_n(&(info->prefetched)[found], __ATOMIC_RELAXED)){
+            __atomic_store_n(&(info->prefetched)[found], FALSE, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&(info->prefetchStats.used), 1, __ATOMIC_RELAXED);
+            *firstUse = TRUE;
+        }
+    }
+    unlockPartition(info, pageNum);
+    return found;
+    
+}
+/**
+ *  Sleep while a page latch still has the given value
+ *
+ *  @param latch The latch word
+ *  @param value The value seen
+ */
+static void latchSleep(unsigned int *latch, unsigned int value){
+#ifdef __linux__
+    syscall(SYS_futex, latch, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+    while(__atomic_load_n(latch, __ATOMIC_ACQUIRE) == value){
+        sched_yield();
+    }
+#endif
+}
+
+/**
+ *  Wake the threads sleeping on a page latch
+ *
+ *  @param latch The latch word
+ */
+static void latchWake(unsigned int *latch){
+#ifdef __linux__
+    syscall(SYS_futex, latch, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)latch;
+#endif
+}
+
+/**
+ *  Acquire a page latch. Readers share it, a writer has it alone; a waiting
+ *  writer keeps new readers out so it is not starved by a hot page. A
+ *  thread which has to wait sets LATCH_SLEEPERS and sleeps on the word.
+ *
+ *  @param latch     The latch word
+ *  @param exclusive Acquire it for writing
+ */
+static void acquireLatch(unsigned int *latch, bool exclusive){
+    unsigned int state = __atomic_load_n(latch, __ATOMIC_RELAXED);
+
+    while(1){
+        unsigned int wait;
+
+        if(exclusive ? (state & (LATCH_EXCLUSIVE | LATCH_READERS)) == 0
+                     : (state & (LATCH_EXCLUSIVE | LATCH_WRITER_WAITING)) == 0){
+            //a writer clears LATCH_WRITER_WAITING, other waiting writers set it again
+            unsigned int next = exclusive ? LATCH_EXCLUSIVE | (state & LATCH_SLEEPERS) : state + 1;
+
+            if(__atomic_compare_exchange_n(latch, &state, next, TRUE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+                return;
+            }
+            continue;
+        }
+        wait = state | LATCH_SLEEPERS | (exclusive ? LATCH_WRITER_WAITING : 0);
+        if(wait != state
+           && !__atomic_compare_exchange_n(latch, &state, wait, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+            continue;
+        }
+        latchSleep(latch, wait);
+        state = __atomic_load_n(latch, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ *  Release a page latch, waking the sleepers when it becomes free
+ *
+ *  @param latch     The latch word
+ *  @param exclusive It was acquired for writing
+ *
+ *  @return The status, RC_PAGE_NOT_LATCHED if it is not held that way
+ */
+static RC releaseLatch(unsigned int *latch, bool exclusive){
+    unsigned int state = __atomic_load_n(latch, __ATOMIC_RELAXED);
+    unsigned int next;
+
+    do{
+        if(exclusive ? !(state & LATCH_EXCLUSIVE) : (state & LATCH_READERS) == 0){
+            return RC_PAGE_NOT_LATCHED;
+        }
+        next = exclusive ? state & LATCH_WRITER_WAITING : state - 1;
+        if((next & LATCH_READERS) == 0){
+            next &= ~LATCH_SLEEPERS;
+        }
+    }while(!__atomic_compare_exchange_n(latch, &state, next, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    if((state & LATCH_SLEEPERS) && !(next & LATCH_SLEEPERS)){
+        latchWake(latch);
+    }
+    return RC_OK;
+}
+
+/**
+ *  Take a bucket from the pool and link it behind previous, or in front of
+ *  all buckets if previous is NULL
+ *
+ *  @param info     The information of buffer pool
+ *  @param count    The count of the bucket
+ *  @param previous The bucket with the next lower count
+ *
+ *  @return the bucket
+ */
+static lfuBucket *lfuNewBucket(bufferInfo *info, int count, lfuBucket *previous){
+    lfuBucket *bucket = info->lfuFreeBuckets;
+
+    info->lfuFreeBuckets = bucket->next;
+    bucket->count = count;
+    bucket->head = NULL;
+    bucket->tail = NULL;
+    bucket->previous = previous;
+    bucket->next = previous ? previous->next : info->lfuLowest;
+    if(bucket->next != NULL){
+        bucket->next->previous = bucket;
+    }
+    if(previous != NULL){
+        previous->next = bucket;
+    }
+    else{
+        info->lfuLowest = bucket;
+    }
+    return bucket;
+}
+
+/**
+ *  Unlink an empty bucket and give it back to the pool
+ *
+ *  @param info   The information of buffer pool
+ *  @param bucket The bucket
+ */
+static void lfuFreeBucket(bufferInfo *info, lfuBucket *bucket){
+    if(bucket->previous != NULL){
+        bucket->previous->next = bucket->next;
+    }
+    else{
+        info->lfuLowest = bucket->next;
+    }
+    if(bucket->next != NULL){
+        bucket->next->previous = bucket->previous;
+    }
+    bucket->next = info->lfuFreeBuckets;
+    info->lfuFreeBuckets = bucket;
+}
+
+/**
+ *  Put a frame at the end of a bucket
+ *
+ *  @param info   The information of buffer pool
+ *  @param bucket The bucket
+ *  @param frame  The frame
+ */
+static void lfuAppend(bufferInfo *info, lfuBucket *bucket, int frame){
+    frameNode *node = &(info->frameNodes[frame]);
+
+    node->next = NULL;
+    node->previous = bucket->tail;
+    if(bucket->tail != NULL){
+        bucket->tail->next = node;
+    }
+    else{
+        bucket->head = node;
+    }
+    bucket->tail = node;
+    (info->frameBucket)[frame] = bucket;
+}
+
+/**
+ *  Take a frame out of its bucket, the bucket goes back to the pool when it gets empty
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void lfuRemove(bufferInfo *info, int frame){
+    frameNode *node = &(info->frameNodes[frame]);
+    lfuBucket *bucket = (info->frameBucket)[frame];
+
+    if(node->previous != NULL){
+        node->previous->next = node->next;
+    }
+    else{
+        bucket->head = node->next;
+    }
+    if(node->next != NULL){
+        node->next->previous = node->previous;
+    }
+    else{
+        bucket->tail = node->previous;
+    }
+    (info->frameBucket)[frame] = NULL;
+    if(bucket->head == NULL){
+        lfuFreeBucket(info, bucket);
+    }
+}
+
+/**
+ *  A page was loaded into a frame, it starts with a count of one
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void lfuInsert(bufferInfo *info, int frame){
+    lfuBucket *bucket = info->lfuLowest;
+
+    if(bucket == NULL || bucket->count != 1){
+        bucket = lfuNewBucket(info, 1, NULL);
+    }
+    lfuAppend(info, bucket, frame);
+}
+
+/**
+ *  Halve the count of every bucket, so pages which were hot long ago lose
+ *  their lead. Buckets which end up with the same count are merged.
+ *
+ *  @param info The information of buffer pool
+ */
+static void lfuAge(bufferInfo *info){
+    lfuBucket *bucket = info->lfuLowest;
+
+    while(bucket != NULL){
+        lfuBucket *next = bucket->next;
+        lfuBucket *previous = bucket->previous;
+
+        bucket->count = bucket->count > 1 ? bucket->count / 2 : 1;
+        if(previous != NULL && previous->count == bucket->count){
+            frameNode *node;
+
+            for(node = bucket->head; node != NULL; node = node->next){
+                (info->frameBucket)[node->frameNum] = previous;
+            }
+            previous->tail->next = bucket->head;
+            bucket->head->previous = previous->tail;
+            previous->tail = bucket->tail;
+            bucket->head = NULL;
+            lfuFreeBucket(info, bucket);
+        }
+        bucket = next;
+    }
+}
+
+/**
+ *  A page in the pool was referenced again, move its frame to the bucket of the next count
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void lfuHit(bufferInfo *info, int frame){
+    lfuBucket *bucket = (info->frameBucket)[frame];
+    lfuBucket *next = bucket->next;
+
+    if(next == NULL || next->count != bucket->count + 1){
+        next = lfuNewBucket(info, bucket->count + 1, bucket);
+    }
+    lfuRemove(info, frame);
+    lfuAppend(info, next, frame);
+}
+
+/**
+ *  Count a pin for aging, every lfuAgingPeriod pins all counts are halved
+ *
+ *  @param info The information of buffer pool
+ */
+static void lfuTick(bufferInfo *info){
+    if(info->lfuAgingPeriod > 0 && ++(info->lfuReferences) >= info->lfuAgingPeriod){
+        lfuAge(info);
+        info->lfuReferences = 0;
+    }
+}
+
+/**
+ *  Pick the least frequently used unpinned frame, the least recently
+ *  referenced one among frames with the same count
+ *
+ *  @param info The information of buffer pool
+ *
+ *  @return The victim frame, NO_FRAME if every frame is pinned
+ */
+static int lfuVictim(bufferInfo *info){
+    lfuBucket *bucket;
+    frameNode *node;
+
+    for(bucket = info->lfuLowest; bucket != NULL; bucket = bucket->next){
+        for(node = bucket->head; node != NULL; node = node->next){
+            if(!framePinned(info, node->frameNum) && claimFrame(info, node->frameNum)){
+                return node->frameNum;
+            }
+        }
+    }
+    return NO_FRAME;
+}
+
+/**
+ *  Whether frame a should be evicted before frame b: the older K-th most
+ *  recent reference first, frames with less than K references (time 0)
+ *  before all others, and the older last reference among equals
+ *
+ *  @param lruK The state of LRU-K
+ *  @param a    A frame
+ *  @param b    A frame
+ *
+ *  @return 1 if a comes first
+ */
+static int lruKBefore(lruKInfo *lruK, int a, int b){
+    long long *historyA = lruK->history + (size_t)a * lruK->k;
+    long long *historyB = lruK->history + (size_t)b * lruK->k;
+
+    if(historyA[lruK->k - 1] != historyB[lruK->k - 1]){
+        return historyA[lruK->k - 1] < historyB[lruK->k - 1];
+    }
+    return historyA[0] < historyB[0];
+}
+
+/**
+ *  Put a frame in a heap slot
+ *
+ *  @param lruK  The state of LRU-K
+ *  @param slot  The heap slot
+ *  @param frame The frame
+ */
+static void lruKPlace(lruKInfo *lruK, int slot, int frame){
+    lruK->heap[slot] = frame;
+    lruK->heapPos[frame] = slot;
+}
+
+/**
+ *  Move the frame in a heap slot up or down until the heap is ordered again
+ *
+ *  @param lruK The state of LRU-K
+ *  @param slot The heap slot
+ */
+static void lruKSift(lruKInfo *lruK, int slot){
+    int frame = lruK->heap[slot];
+
+    while(slot > 0 && lruKBefore(lruK, frame, lruK->heap[(slot - 1) / 2])){
+        lruKPlace(lruK, slot, lruK->heap[(slot - 1) / 2]);
+        slot = (slot - 1) / 2;
+    }
+    while(1){
+        int child = 2 * slot + 1;
+
+        if(child >= lruK->heapSize){
+            break;
+        }
+        if(child + 1 < lruK->heapSize && lruKBefore(lruK, lruK->heap[child + 1], lruK->heap[child])){
+            child++;
+        }
+        if(!lruKBefore(lruK, lruK->heap[child], frame)){
+            break;
+        }
+        lruKPlace(lruK, slot, lruK->heap[child]);
+        slot = child;
+    }
+    lruKPlace(lruK, slot, frame);
+}
+
+/**
+ *  Add a frame to the heap
+ *
+ *  @param lruK  The state of LRU-K
+ *  @param frame The frame
+ */
+static void lruKPush(lruKInfo *lruK, int frame){
+    lruKPlace(lruK, lruK->heapSize++, frame);
+    lruKSift(lruK, lruK->heapSize - 1);
+}
+
+/**
+ *  Take a frame out of the heap
+ *
+ *  @param lruK  The state of LRU-K
+ *  @param frame The frame
+ */
+static void lruKErase(lruKInfo *lruK, int frame){
+    int slot = lruK->heapPos[frame];
+    int last = lruK->heap[--lruK->heapSize];
+
+    lruK->heapPos[frame] = -1;
+    if(last != frame){
+        lruKPlace(lruK, slot, last);
+        lruKSift(lruK, slot);
+    }
+}
+
+/**
+ *  Record a reference to the page in a frame
+ *
+ *  @param lruK  The state of LRU-K
+ *  @param frame The frame
+ */
+static void lruKReference(lruKInfo *lruK, int frame){
+    long long *history = lruK->history + (size_t)frame * lruK->k;
+
+    memmove(history + 1, history, (lruK->k - 1) * sizeof(long long));
+    history[0] = ++lruK->clock;
+    if(lruK->heapPos[frame] >= 0){
+        lruKSift(lruK, lruK->heapPos[frame]);
+    }
+}
+
+/**
+ *  Pick the unpinned frame with the oldest K-th most recent reference.
+ *  Pinned frames met on the way are taken out of the heap and put back.
+ *
+ *  @param info The information of buffer pool
+ *
+ *  @return The victim frame, NO_FRAME if every frame is pinned
+ */
+static int lruKVictim(bufferInfo *info){
+    lruKInfo *lruK = info->lruK;
+    int numSkipped = 0;
+    int victim = NO_FRAME;
+
+    while(lruK->heapSize > 0){
+        int frame = lruK->heap[0];
+
+        if(!framePinned(info, frame) && claimFrame(info, frame)){
+            victim = frame;
+            break;
+        }
+        lruK->skipped[numSkipped++] = frame;
+        lruKErase(lruK, frame);
+    }
+    while(numSkipped > 0){
+        lruKPush(lruK, lruK->skipped[--numSkipped]);
+    }
+    return victim;
+}
+
+/**
+ *  Keep the history of a page which leaves the pool, the oldest retained
+ *  history makes room when the ring is full
+ *
+ *  @param lruK    The state of LRU-K
+ *  @param frame   The frame the page leaves
+ *  @param pageNum The page
+ */
+static void lruKRetain(lruKInfo *lruK, int frame, PageNumber pageNum){
+    int slot = lruK->retainedNext;
+
+    lruK->retainedNext = (slot + 1) % lruK->retainedSize;
+    if(lruK->retainedPages[slot] != NO_PAGE){
+        pageTableRemove(&(lruK->retained), lruK->retainedPages[slot]);
+        lruK->retainedPages[slot] = NO_PAGE;
+    }
+    //the table is sized for every slot, if it still fails the slot stays
+    //empty and the page comes back without history
+    if(pageTablePut(&(lruK->retained), pageNum, slot) != RC_OK){
+        return;
+    }
+    lruK->retainedPages[slot] = pageNum;
+    memcpy(lruK->retainedHistory + (size_t)slot * lruK->k, lruK->history + (size_t)frame * lruK->k,
+           lruK->k * sizeof(long long));
+}
+
+/**
+ *  Give a frame the retained history of the page loaded into it, or an empty one
+ *
+ *  @param lruK    The state of LRU-K
+ *  @param frame   The frame
+ *  @param pageNum The page
+ */
+static void lruKRestore(lruKInfo *lruK, int frame, PageNumber pageNum){
+    long long *history = lruK->history + (size_t)frame * lruK->k;
+    int ring = pageNum == NO_PAGE ? NO_FRAME : pageTableGet(&(lruK->retained), pageNum);
+
+    memset(history, 0, lruK->k * sizeof(long long));
+    if(ring != NO_FRAME){
+        memcpy(history, lruK->retainedHistory + (size_t)ring * lruK->k, lruK->k * sizeof(long long));
+        lruK->retainedPages[ring] = NO_PAGE;
+        pageTableRemove(&(lruK->retained), pageNum);
+    }
+}
+
+/**
+ *  Set up an empty ghost list
+ *
+ *  @param ghost    The ghost list
+ *  @param capacity The number of pages it remembers, 0 for none
+ *
+ *  @return The status
+ */
+static RC initGhostList(ghostList *ghost, int capacity){
+    int i;
+
+    ghost->capacity = capacity;
+    ghost->size = 0;
+    ghost->head = -1;
+    ghost->tail = -1;
+    ghost->freeSlots = capacity > 0 ? 0 : -1;
+    ghost->pages = malloc((capacity + 1) * sizeof(PageNumber));
+    ghost->next = malloc((capacity + 1) * sizeof(int));
+    ghost->previous = malloc((capacity + 1) * sizeof(int));
+    if(ghost->pages == NULL || ghost->next == NULL || ghost->previous == NULL
+       || initPageTable(&(ghost->table), capacity + 1) != RC_OK){
+        return RC_UNESPECTED_ERROR;
+    }
+    for(i = 0; i < capacity; i++){
+        ghost->next[i] = i + 1 < capacity ? i + 1 : -1;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Free the memory of a ghost list
+ *
+ *  @param ghost The ghost list
+ */
+static void freeGhostList(ghostList *ghost){
+    free(ghost->pages);
+    free(ghost->next);
+    free(ghost->previous);
+    freePageTable(&(ghost->table));
+}
+
+/**
+ *  Forget the page in a slot of a ghost list
+ *
+ *  @param ghost The ghost list
+ *  @param slot  The slot
+ */
+static void ghostRemove(ghostList *ghost, int slot){
+    int next = ghost->next[slot];
+    int previous = ghost->previous[slot];
+
+    if(previous >= 0){
+        ghost->next[previous] = next;
+    }
+    else{
+        ghost->head = next;
+    }
+    if(next >= 0){
+        ghost->previous[next] = previous;
+    }
+    else{
+        ghost->tail = previous;
+    }
+    pageTableRemove(&(ghost->table), ghost->pages[slot]);
+    ghost->next[slot] = ghost->freeSlots;
+    ghost->freeSlots = slot;
+    ghost->size--;
+}
+
+/**
+ *  Remember an evicted page as the newest entry of a ghost list
+ *
+ *  @param ghost   The ghost list
+ *  @param pageNum The page
+ */
+static void ghostPush(ghostList *ghost, PageNumber pageNum){
+    int slot;
+
+    if(ghost->capacity == 0){
+        return;
+    }
+    if(ghost->size == ghost->capacity){
+        ghostRemove(ghost, ghost->head);
+    }
+    slot = ghost->freeSlots;
+    ghost->freeSlots = ghost->next[slot];
+    ghost->pages[slot] = pageNum;
+    ghost->next[slot] = -1;
+    ghost->previous[slot] = ghost->tail;
+    if(ghost->tail >= 0){
+        ghost->next[ghost->tail] = slot;
+    }
+    else{
+        ghost->head = slot;
+    }
+    ghost->tail = slot;
+    ghost->size++;
+    pageTablePut(&(ghost->table), pageNum, slot);
+}
+
+/**
+ *  Put a frame at the most recently used end of a list of ARC or 2Q
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame, which is in no list
+ *  @param list  LIST_RECENT or LIST_FREQUENT
+ */
+static void adaptiveAppend(bufferInfo *info, int frame, int list){
+    adaptiveInfo *adaptive = info->adaptive;
+    queue *target = list == LIST_RECENT ? &(adaptive->recent) : &(adaptive->frequent);
+    frameNode *node = &(info->frameNodes[frame]);
+
+    node->next = NULL;
+    node->previous = target->tail;
+    if(target->tail != NULL){
+        target->tail->next = node;
+    }
+    else{
+        target->head = node;
+    }
+    target->tail = node;
+    if(list == LIST_RECENT){
+        adaptive->recentSize++;
+    }
+    else{
+        adaptive->frequentSize++;
+    }
+    adaptive->listOf[frame] = list;
+}
+
+/**
+ *  Take a frame out of its list of ARC or 2Q
+ *
+ *  @param info  The information of buffer pool
+ *  @param frame The frame
+ */
+static void adaptiveRemove(bufferInfo *info, int frame){
+    adaptiveInfo *adaptive = info->adaptive;
+    queue *list = adaptive->listOf[frame] == LIST_RECENT ? &(adaptive->recent) : &(adaptive->frequent);
+    frameNode *node = &(info->frameNodes[frame]);
+
+    if(adaptive->listOf[frame] == LIST_NONE){
+        return;
+    }
+    if(node->previous != NULL){
+        node->previous->next = node->next;
+    }
+    else{
+        list->head = node->next;
+    }
+    if(node->next != NULL){
+        node->next->previous = node->previous;
+    }
+    else{
+        list->tail = node->previous;
+    }
+    if(adaptive->listOf[frame] == LIST_RECENT){
+        adaptive->recentSize--;
+    }
+    else{
+        adaptive->frequentSize--;
+    }
+    adaptive->listOf[frame] = LIST_NONE;
+}
+
+/**
+ *  The least recently used unpinned frame of a list
+ *
+ *  @param info The information of buffer pool
+ *  @param list The list
+ *
+ *  @return The frame, NO_FRAME if every frame of the list is pinned
+ */
+static int listVictim(bufferInfo *info, queue *list){
+    frameNode *node = list->head;
+
+    while(node != NULL && (framePinned(info, node->frameNum) || !claimFrame(info, node->frameNum))){
+        node = node->next;
+    }
+    return node == NULL ? NO_FRAME : node->frameNum;
+}
+
+/**
+ *  Evict a frame of ARC or 2Q, from the recent list or else from the
+ *  frequent one, and remember its page in the ghost list of the list it
+ *  left. If every frame of the wanted list is pinned the other list is tried.
+ *
+ *  @param info       The information of buffer pool
+ *  @param fromRecent Evict from the recent list
+ *
+ *  @return The victim frame, NO_FRAME if every frame is pinned
+ */
+static int adaptiveVictim(bufferInfo *info, bool fromRecent){
+    adaptiveInfo *adaptive = info->adaptive;
+    int frame = listVictim(info, fromRecent ? &(adaptive->recent) : &(adaptive->frequent));
+
+    if(frame == NO_FRAME){
+        frame = listVictim(info, fromRecent ? &(adaptive->frequent) : &(adaptive->recent));
+        if(frame == NO_FRAME){
+            return NO_FRAME;
+        }
+    }
+    if((info->frameToPage)[frame] != NO_PAGE){
+        ghostPush(adaptive->listOf[frame] == LIST_RECENT ? &(adaptive->recentGhosts) : &(adaptive->frequentGhosts),
+                  (info->frameToPage)[frame]);
+    }
+    adaptiveRemove(info, frame);
+    return frame;
+}
+
+/**
+ *  Look a missed page up in the ghost lists of ARC. A ghost hit moves the
+ *  target size of the recent list towards the list the page was evicted
+ *  from too early; otherwise the ghost lists are trimmed so the recent side
+ *  (T1 and B1) holds at most numFrames pages and all lists twice that.
+ *
+ *  @param info      The information of buffer pool
+ *  @param numFrames The number of frames
+ *  @param pageNum   The page
+ *
+ *  @return LIST_RECENT or LIST_FREQUENT for a hit in B1 or B2, else LIST_NONE
+ */
+static int arcGhostHit(bufferInfo *info, int numFrames, PageNumber pageNum){
+    adaptiveInfo *arc = info->adaptive;
+    ghostList *b1 = &(arc->recentGhosts);
+    ghostList *b2 = &(arc->frequentGhosts);
+    int slot;
+
+    if((slot = pageTableGet(&(b1->table), pageNum)) != NO_FRAME){
+        arc->target += b1->size >= b2->size ? 1 : b2->size / b1->size;
+        if(arc->target > numFrames){
+            arc->target = numFrames;
+        }
+        ghostRemove(b1, slot);
+        return LIST_RECENT;
+    }
+    if((slot = pageTableGet(&(b2->table), pageNum)) != NO_FRAME){
+        arc->target -= b2->size >= b1->size ? 1 : b1->size / b2->size;
+        if(arc->target < 0){
+            arc->target = 0;
+        }
+        ghostRemove(b2, slot);
+        return LIST_FREQUENT;
+    }
+    if(arc->recentSize + b1->size >= numFrames){
+        if(b1->size > 0){
+            ghostRemove(b1, b1->head);
+        }
+    }
+    else if(arc->recentSize + arc->frequentSize + b1->size + b2->size >= 2 * numFrames && b2->size > 0){
+        ghostRemove(b2, b2->head);
+    }
+    return LIST_NONE;
+}
+
+/**
+ *  Pick the victim of ARC. The recent list gives up a frame while it is
+ *  larger than the target (or as large, when the page was a ghost of the
+ *  frequent list); when it fills the whole pool its oldest page is dropped
+ *  without a ghost.
+ *
+ *  @param info      The information of buffer pool
+ *  @param numFrames The number of frames
+ *  @param ghostHit  The result of arcGhostHit for the page
+ *
+ *  @return The victim frame, NO_FRAME if every frame is pinned
+ */
+static int arcVictim(bufferInfo *info, int numFrames, int ghostHit){
+    adaptiveInfo *arc = info->adaptive;
+    int frame;
+
+    if(arc->recentSize >= numFrames && (frame = listVictim(info, &(arc->recent))) != NO_FRAME){
+        adaptiveRemove(info, frame);
+        return frame;
+    }
+    return adaptiveVictim(info, arc->recentSize > 0
+                          && (arc->recentSize > arc->target
+                              || (ghostHit == LIST_FREQUENT && arc->recentSize == arc->target)));
+}
+
+/**
+ *  Look a missed page up in A1out, the ghost list of 2Q, and forget it there
+ *
+ *  @param info    The information of buffer pool
+ *  @param pageNum The page
+ *
+ *  @return TRUE if the page was in A1out
+ */
+static bool twoQGhostHit(bufferInfo *info, PageNumber pageNum){
+    ghostList *a1out = &(info->adaptive->recentGhosts);
+    int slot = pageTableGet(&(a1out->table), pageNum);
+
+    if(slot == NO_FRAME){
+        return FALSE;
+    }
+    ghostRemove(a1out, slot);
+    return TRUE;
+}
+
+/**
+ *  Set up the state of the replacement strategy
+ *
+ *  @param info      The information of buffer pool
+ *  @param strategy  The replacement strategy
+ *  @param numFrames The number of frames
+ *  @param stratData The parameter of the strategy, see initBufferPool
+ *
+ *  @return The status
+ */
+static RC initStrategy(bufferInfo *info, ReplacementStrategy strategy, int numFrames, void *stratData){
+    int i;
+
+    switch(strategy)
+    {
+        case RS_LFU:
+            info->lfuBuckets = malloc((numFrames + 1) * sizeof(lfuBucket));
+            info->frameBucket = calloc(numFrames, sizeof(lfuBucket *));
+            if(info->lfuBuckets == NULL || info->frameBucket == NULL){
+                return RC_UNESPECTED_ERROR;
+            }
+            for(i = 0; i < numFrames; i++){
+                info->lfuBuckets[i].next = &(info->lfuBuckets[i + 1]);
+            }
+            info->lfuBuckets[numFrames].next = NULL;
+            info->lfuFreeBuckets = info->lfuBuckets;
+            info->lfuLowest = NULL;
+            info->lfuAgingPeriod = stratData ? *(int *)stratData : 0;
+            info->lfuReferences = 0;
+            break;
+        case RS_LRU_K:
+            info->lruK = calloc(1, sizeof(lruKInfo));
+            if(info->lruK == NULL){
+                return RC_UNESPECTED_ERROR;
+            }
+            lruKInfo *lruK = info->lruK;
+            lruK->k = stratData ? *(int *)stratData : 2;
+            if(lruK->k < 1){
+                lruK->k = 1;
+            }
+            if(lruK->k > MAX_K){
+                lruK->k = MAX_K;
+            }
+            //as many retained histories as there are frames
+            lruK->retainedSize = numFrames;
+            lruK->history = calloc((size_t)numFrames * lruK->k, sizeof(long long));
+            lruK->heap = malloc(numFrames * sizeof(int));
+            lruK->heapPos = malloc(numFrames * sizeof(int));
+            lruK->skipped = malloc(numFrames * sizeof(int));
+            lruK->retainedPages = malloc(numFrames * sizeof(PageNumber));
+            lruK->retainedHistory = malloc((size_t)numFrames * lruK->k * sizeof(long long));
+            if(lruK->history == NULL || lruK->heap == NULL || lruK->heapPos == NULL || lruK->skipped == NULL
+               || lruK->retainedPages == NULL || lruK->retainedHistory == NULL
+               || initPageTable(&(lruK->retained), numFrames) != RC_OK){
+                return RC_UNESPECTED_ERROR;
+            }
+            for(i = 0; i < numFrames; i++){
+                lruK->heapPos[i] = -1;
+                lruK->retainedPages[i] = NO_PAGE;
+            }
+            break;
+        case RS_ARC:
+        case RS_2Q:
+            info->adaptive = calloc(1, sizeof(adaptiveInfo));
+            if(info->adaptive == NULL){
+                return RC_UNESPECTED_ERROR;
+            }
+            adaptiveInfo *adaptive = info->adaptive;
+            adaptive->listOf = calloc(numFrames, sizeof(char));
+            if(adaptive->listOf == NULL){
+                return RC_UNESPECTED_ERROR;
+            }
+            if(strategy == RS_ARC){
+                //B1 and B2 never hold more than numFrames pages together
+                adaptive->target = 0;
+                if(initGhostList(&(adaptive->recentGhosts), numFrames) != RC_OK
+                   || initGhostList(&(adaptive->frequentGhosts), numFrames) != RC_OK){
+                    return RC_UNESPECTED_ERROR;
+                }
+            }
+            else{
+                //Kin is a quarter of the pool by default, A1out remembers half as many pages as there are frames
+                adaptive->target = numFrames * (stratData ? *(int *)stratData : 25) / 100;
+                if(adaptive->target < 1){
+                    adaptive->target = 1;
+                }
+                if(initGhostList(&(adaptive->recentGhosts), numFrames / 2 > 0 ? numFrames / 2 : 1) != RC_OK
+                   || initGhostList(&(adaptive->frequentGhosts), 0) != RC_OK){
+                    return RC_UNESPECTED_ERROR;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Free the state of the replacement strategy
+ *
+ *  @param info     The information of buffer pool
+ *  @param strategy The replacement strategy
+ */
+static void freeStrategy(bufferInfo *info, ReplacementStrategy strategy){
+    switch(strategy)
+    {
+        case RS_LFU:
+            free(info->lfuBuckets);
+            free(info->frameBucket);
+            break;
+        case RS_LRU_K:
+            if(info->lruK != NULL){
+                free(info->lruK->history);
+                free(info->lruK->heap);
+                free(info->lruK->heapPos);
+                free(info->lruK->skipped);
+                free(info->lruK->retainedPages);
+                free(info->lruK->retainedHistory);
+                freePageTable(&(info->lruK->retained));
+                free(info->lruK);
+                info->lruK = NULL;
+            }
+            break;
+        case RS_ARC:
+        case RS_2Q:
+            if(info->adaptive != NULL){
+                free(info->adaptive->listOf);
+                freeGhostList(&(info->adaptive->recentGhosts));
+                freeGhostList(&(info->adaptive->frequentGhosts));
+                free(info->adaptive);
+                info->adaptive = NULL;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ *  Pick a victim with the CLOCK (second chance) policy. The hand sweeps over
+ *  the frames; a frame whose reference bit is set gets the bit cleared and is
+ *  passed over once, pinned frames are skipped. Two rounds are enough to
+ *  find a victim if there is one.
+ *
+ *  @param info      The information of buffer pool
+ *  @param numFrames The number of frames
+ *
+ *  @return The victim frame, NO_FRAME if every frame is pinned
+ */
+static int clockVictim(bufferInfo *info, int numFrames){
+    int steps;
+
+    for(steps = 0; steps < 2 * numFrames; steps++){
+        int frame = info->clockHand;
+
+        info->clockHand = frame + 1 == numFrames ? 0 : frame + 1;
+        if(framePinned(info, frame)){
+            continue;
+        }
+        //hits set the bit without strategyLatch
+        if(__atomic_load_n(&(info->refBits)[frame], __ATOMIC_RELAXED)){
+            __atomic_store_n(&(info->refBits)[frame], FALSE, __ATOMIC_RELAXED);
+            continue;
+        }
+        if(claimFrame(info, frame)){
+            return frame;
+        }
+    }
+    return NO_FRAME;
+}
+
+/**
+ *  Write the page of a frame to disk. The frame must not be evicted
+ *  meanwhile, the caller keeps it pinned. It is clean while it is written,
+ *  so a thread marking it dirty again is not lost.
+ *
+ *  @param info    The information of buffer pool
+ *  @param frame   The frame
+ *  @param pageNum The page in the frame
+ *
+ *  @return The status
+ */
+static RC writeFrame(bufferInfo *info, int frame, PageNumber pageNum){
+    long long since = setClean(info, frame);
+    RC status;
+
+    lockFile(info, FALSE);
+    status = writeBlock(pageNum, &(info->fileHandle), frameAddress(info, frame));
+    unlockFile(info);
+    if(status != RC_OK){
+        if(since != 0){
+            setDirty(info, frame, since);
+        }
+        return RC_WRITE_FAILED;
+    }
+    __atomic_fetch_add(&(info->writeTimes), 1, __ATOMIC_RELAXED);
+    return RC_OK;
+}
+
+/**
+ *  Record a pin of a page which is in the pool
+ *
+ *  @param info     The information of buffer pool
+ *  @param strategy The replacement strategy
+ *  @param frame    The frame holding the page
+ *
+ *  @return The status
+ */
+static RC strategyHit(bufferInfo *info, ReplacementStrategy strategy, int frame){
+    RC status = RC_OK;
+
+    //FIFO ignores hits and CLOCK only sets a bit, neither needs strategyLatch
+    switch(strategy)
+    {
+        case RS_FIFO:
+            return RC_OK;
+        case RS_CLOCK:
+            __atomic_store_n(&(info->refBits)[frame], TRUE, __ATOMIC_RELAXED);
+            return RC_OK;
+        default:
+            break;
+    }
+
+    lockStrategy(info);
+    switch(strategy)
+    {
+        case RS_LRU:
+            enQueue(&(info->frames), &(info->frameNodes[frame]));
+            break;
+        case RS_LFU:
+            lfuTick(info);
+            lfuHit(info, frame);
+            break;
+        case RS_LRU_K:
+            lruKReference(info->lruK, frame);
+            break;
+        case RS_ARC:
+            //a second reference makes the page frequent
+            adaptiveRemove(info, frame);
+            adaptiveAppend(info, frame, LIST_FREQUENT);
+            break;
+        case RS_2Q:
+            //hits in A1in are not counted, the page may be part of a scan
+            if(info->adaptive->listOf[frame] == LIST_FREQUENT){
+                adaptiveRemove(info, frame);
+                adaptiveAppend(info, frame, LIST_FREQUENT);
+            }
+            break;
+        default:
+            status = RC_UNKNOWN_STRATEGY;
+            break;
+    }
+    unlockStrategy(info);
+    return status;
+}
+
+/**
+ *  Pick the frame a missed page is loaded into, a free one while there is
+ *  one and else a victim, and record the page in the replacement state.
+ *  Called with strategyLatch held.
+ *
+ *  @param bm      The buffer pool
+ *  @param pageNum The page
+ *  @param frame   Set to the frame
+ *
+ *  @return The status, RC_NO_MORE_SPACE_IN_BUFFER if every frame is pinned
+ */
+static RC strategyFrame(BM_BufferPool *const bm, const PageNumber pageNum, int *frame){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    int currentNumFrame = bminfo->frameNumInBuffer;
+    int totalNumFrame = bm->numPages;
+    int target;
+    int ghostHit;
+    frameNode *node;
+    
+    switch (bm->strategy)
+    {
+        case RS_FIFO:
+        case RS_LRU:
+            
+            //the same list, FIFO just does not move a page on a hit
+            if(currentNumFrame == totalNumFrame){
+                
+                node = bminfo->frames->head;
+                while(node != NULL && (framePinned(bminfo, node->frameNum) || !claimFrame(bminfo, node->frameNum))){
+                    node = node->next;
+                }
+                
+                if (node == NULL){
+                    return RC_NO_MORE_SPACE_IN_BUFFER;
+                }
+            }
+            else{
+                //frames are filled in the order of frame number
+                node = &(bminfo->frameNodes[currentNumFrame]);
+                (bminfo->frameNumInBuffer)++;
+            }
+            enQueue(&(bminfo->frames), node);
+            target = node->frameNum;
+            
+            break;
+        case RS_CLOCK:
+            
+            if(currentNumFrame == totalNumFrame){
+                target = clockVictim(bminfo, totalNumFrame);
+                if(target == NO_FRAME){
+                    return RC_NO_MORE_SPACE_IN_BUFFER;
+                }
+            }
+            else{
+                target = currentNumFrame;
+                (bminfo->frameNumInBuffer)++;
+            }
+            __atomic_store_n(&(bminfo->refBits)[target], FALSE, __ATOMIC_RELAXED);
+            
+            break;
+        case RS_LFU:
+            
+            lfuTick(bminfo);
+            if(currentNumFrame == totalNumFrame){
+                target = lfuVictim(bminfo);
+                if(target == NO_FRAME){
+                    return RC_NO_MORE_SPACE_IN_BUFFER;
+                }
+                lfuRemove(bminfo, target);
+            }
+            else{
+                target = currentNumFrame;
+                (bminfo->frameNumInBuffer)++;
+            }
+            
+            //the frame is counted again even if the read fails, it holds no page then
+            lfuInsert(bminfo, target);
+            
+            break;
+        case RS_LRU_K:
+            
+            if(currentNumFrame == totalNumFrame){
+                target = lruKVictim(bminfo);
+                if(target == NO_FRAME){
+                    return RC_NO_MORE_SPACE_IN_BUFFER;
+                }
+                lruKErase(bminfo->lruK, target);
+                if((bminfo->frameToPage)[target] != NO_PAGE){
+                    lruKRetain(bminfo->lruK, target, (bminfo->frameToPage)[target]);
+                }
+            }
+            else{
+                target = currentNumFrame;
+                (bminfo->frameNumInBuffer)++;
+            }
+            
+            lruKRestore(bminfo->lruK, target, pageNum);
+            lruKReference(bminfo->lruK, target);
+            lruKPush(bminfo->lruK, target);
+            
+            break;
+        case RS_ARC:
+        case RS_2Q:
+            
+            if(bm->strategy == RS_ARC){
+                ghostHit = arcGhostHit(bminfo, totalNumFrame, pageNum);
+            }
+            else{
+                ghostHit = twoQGhostHit(bminfo, pageNum) ? LIST_RECENT : LIST_NONE;
+            }
+            if(currentNumFrame == totalNumFrame){
+                target = bm->strategy == RS_ARC ? arcVictim(bminfo, totalNumFrame, ghostHit)
+                       : adaptiveVictim(bminfo, bminfo->adaptive->recentSize > bminfo->adaptive->target);
+                if(target == NO_FRAME){
+                    return RC_NO_MORE_SPACE_IN_BUFFER;
+                }
+            }
+            else{
+                target = currentNumFrame;
+                (bminfo->frameNumInBuffer)++;
+            }
+            
+            adaptiveAppend(bminfo, target, ghostHit == LIST_NONE ? LIST_RECENT : LIST_FREQUENT);
+            
+            break;
+        default:
+            return RC_UNKNOWN_STRATEGY;
+            break;
+    }
+    *frame = target;
+    return RC_OK;
+}
+
+/**
+ *  Write the page of a frame back if it is dirty. The frame is pinned so it
+ *  is not evicted meanwhile; frames in I/O are left to their thread.
+ *
+ *  @param info    The information of buffer pool
+ *  @param frame   The frame
+ *  @param written Set to TRUE if the page was written
+ *
+ *  @return The status
+ */
+static RC flushFrame(bufferInfo *info, int frame, bool *written){
+    PageNumber pageNum = __atomic_load_n(&(info->frameToPage)[frame], __ATOMIC_RELAXED);
+    RC status;
+
+    *written = FALSE;
+    if(pageNum == NO_PAGE || !__atomic_load_n(&(info->dirtyFlags)[frame], __ATOMIC_RELAXED)){
+        return RC_OK;
+    }
+    lockPartition(info, pageNum);
+    if(__atomic_load_n(&(info->frameToPage)[frame], __ATOMIC_RELAXED) != pageNum
+       || __atomic_load_n(&(info->ioBusy[frame]), __ATOMIC_ACQUIRE)){
+        unlockPartition(info, pageNum);
+        return RC_OK;
+    }
+    fixFrame(info, frame, 1);
+    unlockPartition(info, pageNum);
+
+    status = writeFrame(info, frame, pageNum);
+
+    lockPartition(info, pageNum);
+    fixFrame(info, frame, -1);
+    unlockPartition(info, pageNum);
+    *written = status == RC_OK;
+    return status;
+}
+
+/**
+ *  Add a frame to the eviction candidates if it holds a page and is not pinned
+ *
+ *  @param info       The information of buffer pool
+ *  @param candidates The candidates so far
+ *  @param count      The number of candidates so far
+ *  @param frame      The frame
+ *
+ *  @return The new number of candidates
+ */
+static int addCandidate(bufferInfo *info, int *candidates, int count, int frame){
+    if(__atomic_load_n(&(info->frameToPage)[frame], __ATOMIC_RELAXED) == NO_PAGE
+       || framePinned(info, frame) || __atomic_load_n(&(info->ioBusy[frame]), __ATOMIC_RELAXED)){
+        return count;
+    }
+    candidates[count] = frame;
+    return count + 1;
+}
+
+/**
+ *  The frames the strategy will evict next, the first one first, without
+ *  changing the replacement state. LRU-K takes them in heap order, which
+ *  starts with the next victim but is only roughly ordered after it.
+ *  Called with strategyLatch held.
+ *
+ *  @param bm         The buffer pool
+ *  @param candidates Set to the frames
+ *  @param max        The most frames wanted
+ *
+ *  @return The number of frames found
+ */
+static int strategyCandidates(BM_BufferPool *const bm, int *candidates, int max){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    adaptiveInfo *adaptive = bminfo->adaptive;
+    int numFrames = bm->numPages;
+    int count = 0;
+    int lap, i;
+    frameNode *node;
+    lfuBucket *bucket;
+    queue *lists[2];
+
+    switch (bm->strategy)
+    {
+        case RS_FIFO:
+        case RS_LRU:
+            for(node = bminfo->frames->head; node != NULL && count < max; node = node->next){
+                count = addCandidate(bminfo, candidates, count, node->frameNum);
+            }
+            break;
+        case RS_CLOCK:
+            //frames with the reference bit set come in the second lap of the hand
+            for(lap = 0; lap < 2; lap++){
+                for(i = 0; i < numFrames && count < max; i++){
+                    int frame = (bminfo->clockHand + i) % numFrames;
+
+                    if(__atomic_load_n(&(bminfo->refBits)[frame], __ATOMIC_RELAXED) == (lap == 1)){
+                        count = addCandidate(bminfo, candidates, count, frame);
+                    }
+                }
+            }
+            break;
+        case RS_LFU:
+            for(bucket = bminfo->lfuLowest; bucket != NULL && count < max; bucket = bucket->next){
+                for(node = bucket->head; node != NULL && count < max; node = node->next){
+                    count = addCandidate(bminfo, candidates, count, node->frameNum);
+                }
+            }
+            break;
+        case RS_LRU_K:
+            for(i = 0; i < bminfo->lruK->heapSize && count < max; i++){
+                count = addCandidate(bminfo, candidates, count, bminfo->lruK->heap[i]);
+            }
+            break;
+        case RS_ARC:
+        case RS_2Q:
+            lists[0] = adaptive->recentSize > adaptive->target ? &(adaptive->recent) : &(adaptive->frequent);
+            lists[1] = lists[0] == &(adaptive->recent) ? &(adaptive->frequent) : &(adaptive->recent);
+            for(i = 0; i < 2; i++){
+                for(node = lists[i]->head; node != NULL && count < max; node = node->next){
+                    count = addCandidate(bminfo, candidates, count, node->frameNum);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return count;
+}
+
+/**
+ *  One round of the background writer: write back the dirty pages among
+ *  the frames next in line for eviction
+ *
+ *  @param bm The buffer pool
+ */
+static void cleanCandidates(BM_BufferPool *const bm){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    int *candidates = bminfo->writerCandidates;
+    int count, dirty = 0, written = 0;
+    bool wrote;
+    int i;
+
+    lockStrategy(bminfo);
+    count = strategyCandidates(bm, candidates, bminfo->writerWindow);
+    unlockStrategy(bminfo);
+
+    for(i = 0; i < count; i++){
+        if(__atomic_load_n(&(bminfo->dirtyFlags)[candidates[i]], __ATOMIC_RELAXED)){
+            candidates[dirty++] = candidates[i];
+        }
+    }
+    for(i = 0; i < dirty; i++){
+        if(flushFrame(bminfo, candidates[i], &wrote) == RC_OK && wrote){
+            written++;
+        }
+    }
+
+    pthread_mutex_lock(&(bminfo->writerLatch));
+    bminfo->writerStats.rounds++;
+    bminfo->writerStats.pagesWritten += written;
+    bminfo->writerStats.queueLength = dirty;
+    if(dirty > bminfo->writerStats.maxQueueLength){
+        bminfo->writerStats.maxQueueLength = dirty;
+    }
+    pthread_mutex_unlock(&(bminfo->writerLatch));
+}
+
+/**
+ *  The background writer: a round every writerIntervalMs, or as soon as a
+ *  miss had to write a dirty victim itself
+ *
+ *  @param arg The buffer pool
+ *
+ *  @return NULL
+ */
+static void *backgroundWriter(void *arg){
+    BM_BufferPool *bm = (BM_BufferPool *)arg;
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+
+    pthread_mutex_lock(&(bminfo->writerLatch));
+    while(!bminfo->writerStop){
+        struct timespec deadline;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long)bminfo->writerIntervalMs * 1000000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        pthread_cond_timedwait(&(bminfo->writerWake), &(bminfo->writerLatch), &deadline);
+        if(bminfo->writerStop){
+            break;
+        }
+        pthread_mutex_unlock(&(bminfo->writerLatch));
+        cleanCandidates(bm);
+        pthread_mutex_lock(&(bminfo->writerLatch));
+    }
+    pthread_mutex_unlock(&(bminfo->writerLatch));
+    return NULL;
+}
+
+/**
+ *  Start the background writer of a pool if the options ask for one
+ *
+ *  @param bm      The buffer pool
+ *  @param options The options of the pool, may be NULL
+ *
+ *  @return The status
+ */
+static RC startWriter(BM_BufferPool *const bm, const BM_PoolOptions *options){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    int cleanPercent = options ? options->cleanPercent : 0;
+
+    memset(&(bminfo->writerStats), 0, sizeof(BM_WriterStats));
+    bminfo->writerWindow = 0;
+    bminfo->writerCandidates = NULL;
+    if(cleanPercent <= 0){
+        return RC_OK;
+    }
+    bminfo->writerWindow = (bm->numPages * (cleanPercent > 100 ? 100 : cleanPercent) + 99) / 100;
+    bminfo->writerIntervalMs = options->writerIntervalMs > 0 ? options->writerIntervalMs : 10;
+    bminfo->writerCandidates = malloc(bminfo->writerWindow * sizeof(int));
+    if(bminfo->writerCandidates == NULL){
+        bminfo->writerWindow = 0;
+        return RC_UNESPECTED_ERROR;
+    }
+    bminfo->writerStop = FALSE;
+    pthread_mutex_init(&(bminfo->writerLatch), NULL);
+    pthread_cond_init(&(bminfo->writerWake), NULL);
+    clock_gettime(CLOCK_MONOTONIC, &(bminfo->writerStart));
+    if(pthread_create(&(bminfo->writer), NULL, backgroundWriter, bm) != 0){
+        pthread_mutex_destroy(&(bminfo->writerLatch));
+        pthread_cond_destroy(&(bminfo->writerWake));
+        free(bminfo->writerCandidates);
+        bminfo->writerCandidates = NULL;
+        bminfo->writerWindow = 0;
+        return RC_UNESPECTED_ERROR;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Stop the background writer of a pool, if it has one
+ *
+ *  @param info The information of buffer pool
+ */
+static void stopWriter(bufferInfo *info){
+    if(info->writerWindow == 0){
+        return;
+    }
+    pthread_mutex_lock(&(info->writerLatch));
+    info->writerStop = TRUE;
+    pthread_cond_signal(&(info->writerWake));
+    pthread_mutex_unlock(&(info->writerLatch));
+    pthread_join(info->writer, NULL);
+    pthread_mutex_destroy(&(info->writerLatch));
+    pthread_cond_destroy(&(info->writerWake));
+    free(info->writerCandidates);
+    info->writerCandidates = NULL;
+    info->writerWindow = 0;
+}
+
+/**
+ *  Give a frame a scan ring takes back to another page in the replacement
+ *  state, as strategyFrame does for a victim: its page leaves the state
+ *  (LRU-K keeps its history, ARC and 2Q remember it in a ghost list) and
+ *  the new page starts with one reference. FIFO and LRU keep the frame at
+ *  its place in the list, so the ring stays next in line for eviction.
+ *  Called with strategyLatch held.
+ *
+ *  @param bm      The buffer pool
+ *  @param frame   The frame, claimed
+ *  @param pageNum The page it is loaded with
+ */
+static void strategyReuse(BM_BufferPool *const bm, int frame, const PageNumber pageNum){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    PageNumber oldPage = (bminfo->frameToPage)[frame];
+    adaptiveInfo *adaptive = bminfo->adaptive;
+    int ghostHit;
+
+    switch (bm->strategy)
+    {
+        case RS_CLOCK:
+            //a second chance would keep the scan page from the main pool
+            __atomic_store_n(&(bminfo->refBits)[frame], FALSE, __ATOMIC_RELAXED);
+            break;
+        case RS_LFU:
+            lfuTick(bminfo);
+            lfuRemove(bminfo, frame);
+            lfuInsert(bminfo, frame);
+            break;
+        case RS_LRU_K:
+            lruKErase(bminfo->lruK, frame);
+            if(oldPage != NO_PAGE){
+                lruKRetain(bminfo->lruK, frame, oldPage);
+            }
+            lruKRestore(bminfo->lruK, frame, pageNum);
+            lruKReference(bminfo->lruK, frame);
+            lruKPush(bminfo->lruK, frame);
+            break;
+        case RS_ARC:
+        case RS_2Q:
+            if(bm->strategy == RS_ARC){
+                ghostHit = arcGhostHit(bminfo, bm->numPages, pageNum);
+            }
+            else{
+                ghostHit = twoQGhostHit(bminfo, pageNum) ? LIST_RECENT : LIST_NONE;
+            }
+            if(oldPage != NO_PAGE){
+                ghostPush(adaptive->listOf[frame] == LIST_RECENT ? &(adaptive->recentGhosts) : &(adaptive->frequentGhosts),
+                          oldPage);
+            }
+            adaptiveRemove(bminfo, frame);
+            adaptiveAppend(bminfo, frame, ghostHit == LIST_NONE ? LIST_RECENT : LIST_FREQUENT);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ *  Pick the frame for a missed page. A scan with a ring reuses the frame it
+ *  loaded ring size misses ago, if that still holds its page and is not
+ *  pinned, and only asks the strategy otherwise; the reused frame's state
+ *  is reset by strategyReuse. Without a ring, misses on consecutive
+ *  pages are counted and a run longer than scanThreshold goes to the ring
+ *  of the pool. Called with strategyLatch held.
+ *
+ *  @param bm      The buffer pool
+ *  @param ring    The ring of the scan, NULL for a plain pin
+ *  @param pageNum The page
+ *  @param frame   Set to the frame
+ *
+ *  @return The status, RC_NO_MORE_SPACE_IN_BUFFER if every frame is pinned
+ */
+static RC ringFrame(BM_BufferPool *const bm, BM_ScanRing *ring, const PageNumber pageNum, int *frame){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    int slot, target;
+    RC status;
+
+    if(ring == NULL && bminfo->scanThreshold > 0){
+        bminfo->missRun = pageNum == bminfo->lastMiss + 1 ? bminfo->missRun + 1 : 1;
+        bminfo->lastMiss = pageNum;
+        if(bminfo->missRun > bminfo->scanThreshold){
+            ring = bminfo->scanRing;
+        }
+    }
+    if(ring == NULL){
+        return strategyFrame(bm, pageNum, frame);
+    }
+
+    slot = ring->next;
+    ring->next = slot + 1 == ring->size ? 0 : slot + 1;
+    target = ring->frames[slot];
+    if(target != NO_FRAME && ring->pages[slot] != NO_PAGE
+       && __atomic_load_n(&(bminfo->frameToPage)[target], __ATOMIC_RELAXED) == ring->pages[slot]
+       && !framePinned(bminfo, target) && claimFrame(bminfo, target)){
+        strategyReuse(bm, target, pageNum);
+    }
+    else if((status = strategyFrame(bm, pageNum, &target)) != RC_OK){
+        return status;
+    }
+    ring->frames[slot] = target;
+    ring->pages[slot] = pageNum;
+    *frame = target;
+    return RC_OK;
+}
+
+/**
+ *  Empty a frame taken for another page: write its page back if it is
+ *  dirty and take it out of the page table. A prefetched page which was
+ *  never pinned is counted as unused.
+ *
+ *  @param info  The information of buffer pool
+ *  @param found The frame
+ *  @param moved Set to TRUE if the frame held a page, whose version is now changing
+ *
+ *  @return The status, the frame keeps its page if it could not be written
+ */
+static RC evictPage(bufferInfo *info, int found, bool *moved){
+    SM_FileHandle *fHandle = &(info->fileHandle);
+    PageNumber oldPage = (info->frameToPage)[found];
+    RC status = RC_OK;
+    
+    *moved = FALSE;
+    if((info->dirtyFlags)[found]){
+        lockFile(info, FALSE);
+        status = writeBlock(oldPage, fHandle, frameAddress(info, found));
+        unlockFile(info);
+        if(status == RC_OK){
+            __atomic_fetch_add(&(info->writeTimes), 1, __ATOMIC_RELAXED);
+            setClean(info, found);
+        }
+        __atomic_fetch_add(&(info->writerStats.dirtyEvictions), 1, __ATOMIC_RELAXED);
+        //the writer is behind, let it start its next round now
+        if(info->writerWindow > 0){
+            pthread_mutex_lock(&(info->writerLatch));
+            pthread_cond_signal(&(info->writerWake));
+            pthread_mutex_unlock(&(info->writerLatch));
+        }
+    }
+    if(status == RC_OK && oldPage != NO_PAGE){
+        lockPartition(info, oldPage);
+        pageTableRemove(partitionOf(info, oldPage), oldPage);
+        beginFrameChange(info, found);
+        __atomic_store_n(&(info->frameToPage)[found], NO_PAGE, __ATOMIC_RELAXED);
+        //handles of the old page are stale from now on
+        __atomic_fetch_add(&(info->frameGenerations)[found], 1, __ATOMIC_RELAXED);
+        unlockPartition(info, oldPage);
+        *moved = TRUE;
+    }
+    if(status == RC_OK && __atomic_load_n(&(info->prefetched)[found], __ATOMIC_RELAXED)){
+        __atomic_store_n(&(info->prefetched)[found], FALSE, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&(info->prefetchStats.unused), 1, __ATOMIC_RELAXED);
+    }
+    return status;
+}
+
+/**
+ *  A missed page of pinPage or pinPages. frame is the frame the page is
+ *  loaded into, for the first request of each page; the others pin it again.
+ */
+typedef struct pinRequest{
+    PageNumber pageNum;
+    int index;          //of the page in the arguments of pinPages
+    int frame;
+    bool moved;         //the frame held a page before, see evictPage
+}pinRequest;
+
+/**
+ *  Order the missed pages of pinPages by page number
+ *
+ *  @param a A pinRequest
+ *  @param b A pinRequest
+ *
+ *  @return <0, 0 or >0 as for qsort
+ */
+static int comparePinRequests(const void *a, const void *b){
+    const pinRequest *x = (const pinRequest *)a;
+    const pinRequest *y = (const pinRequest *)b;
+
+    if(x->pageNum != y->pageNum){
+        return x->pageNum < y->pageNum ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+/**
+ *  Take a frame for a missed page, from the ring of a scan if it has one.
+ *  The frame is busy and the page is in the page table, so other threads
+ *  wait for it instead of loading it too. A pin holds the frame from now on,
+ *  a prefetch only keeps it busy until its read is collected. The old page is
+ *  still in the frame, see evictPage. Called with strategyLatch held. Unless
+ *  the miss is a prefetch, the latch is dropped while the reads of prefetches
+ *  holding every frame are collected.
+ *
+ *  @param bm       The buffer pool
+ *  @param ring     The ring, NULL to use the whole pool
+ *  @param pageNum  The page
+ *  @param prefetch The miss is a prefetch, which does not wait for a frame
+ *  @param frame    Set to the frame, NO_FRAME if the page is in the pool already
+ *
+ *  @return The status
+ */
+static RC claimMissFrame(BM_BufferPool *const bm, BM_ScanRing *ring, const PageNumber pageNum,
+                         bool prefetch, int *frame){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    int target;
+    RC status;
+
+    *frame = NO_FRAME;
+    while(1){
+        //only threads holding strategyLatch add pages, another one may have added it before
+        lockPartition(bminfo, pageNum);
+        target = findFramewithPageNum(bminfo, pageNum);
+        unlockPartition(bminfo, pageNum);
+        if(target != NO_FRAME){
+            return RC_OK;
+        }
+        status = prefetch ? strategyFrame(bm, pageNum, &target) : ringFrame(bm, ring, pageNum, &target);
+        //frames held by prefetch reads come free once these are collected
+        if(prefetch || status != RC_NO_MORE_SPACE_IN_BUFFER
+           || __atomic_load_n(&(bminfo->prefetchStats.inFlight), __ATOMIC_RELAXED) == 0){
+            break;
+        }
+        unlockStrategy(bminfo);
+        reapPrefetches(bminfo, TRUE);
+        lockStrategy(bminfo);
+    }
+    if(status != RC_OK){
+        return status;
+    }
+
+    //a prefetched page is busy in every pool, so a pin of it collects the read
+    if(prefetch || bminfo->partitionLatches != NULL){
+        __atomic_store_n(&(bminfo->ioBusy[target]), TRUE, __ATOMIC_RELAXED);
+    }
+    if(!prefetch){
+        fixFrame(bminfo, target, 1);
+    }
+    lockPartition(bminfo, pageNum);
+    status = pageTablePut(partitionOf(bminfo, pageNum), pageNum, target);
+    unlockPartition(bminfo, pageNum);
+    if(status != RC_OK){
+        if(!prefetch){
+            fixFrame(bminfo, target, -1);
+        }
+        releaseFrame(bminfo, target);
+        return status;
+    }
+    *frame = target;
+    return RC_OK;
+}
+
+/**
+ *  Give up a frame claimed by claimMissFrame whose page could not be loaded.
+ *  The frame keeps its old page if evictPage did not move it out.
+ *
+ *  @param info     The information of buffer pool
+ *  @param pageNum  The missed page
+ *  @param frame    The frame
+ *  @param prefetch The miss is a prefetch, which did not pin the frame
+ *  @param moved    The old page was moved out, see evictPage
+ */
+static void abandonMiss(bufferInfo *info, const PageNumber pageNum, int frame, bool prefetch, bool moved){
+    lockPartition(info, pageNum);
+    pageTableRemove(partitionOf(info, pageNum), pageNum);
+    if(!prefetch){
+        fixFrame(info, frame, -1);
+    }
+    unlockPartition(info, pageNum);
+    if(moved){
+        endFrameChange(info, frame);
+    }
+    releaseFrame(info, frame);
+}
+
+/**
+ *  Read missed pages. Frames for all of them are taken under one hold of
+ *  strategyLatch, then the old pages are written back and each run of
+ *  consecutive pages is read with one vectored read. In a concurrent pool
+ *  the frames are ioBusy meanwhile and no latch is held, so other threads
+ *  can go on with the pages in the pool. A loaded page is pinned once;
+ *  requests without a frame were either loaded by another thread meanwhile
+ *  or failed.
+ *
+ *  @param bm          The buffer pool
+ *  @param ring        The ring of a scan, NULL to use the whole pool
+ *  @param requests    The missed pages, sorted by page number
+ *  @param numRequests The number of missed pages
+ *
+ *  @return The status of the first failure
+ */
+static RC loadPages(BM_BufferPool *const bm, BM_ScanRing *ring, pinRequest *requests, int numRequests){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    SM_FileHandle *fHandle = &(bminfo->fileHandle);
+    SM_PageHandle buffers[LOAD_RUN_PAGES];
+    RC status = RC_OK;
+    RC loaded;
+    int i, j, count;
+    bool extend;
+
+    lockStrategy(bminfo);
+    for(i = 0; i < numRequests && status == RC_OK; i++){
+        if(i > 0 && requests[i].pageNum == requests[i - 1].pageNum){
+            continue;
+        }
+        //pinned at once, so the next misses of the batch do not take the frame
+        status = claimMissFrame(bm, ring, requests[i].pageNum, FALSE, &(requests[i].frame));
+    }
+    unlockStrategy(bminfo);
+
+    for(i = 0; i < numRequests; i++){
+        if(requests[i].frame != NO_FRAME
+           && (loaded = evictPage(bminfo, requests[i].frame, &(requests[i].moved))) != RC_OK){
+            abandonMiss(bminfo, requests[i].pageNum, requests[i].frame, FALSE, FALSE);
+            requests[i].frame = NO_FRAME;
+            status = status == RC_OK ? loaded : status;
+        }
+    }
+
+    for(i = 0; i < numRequests; i = j){
+        if(requests[i].frame == NO_FRAME){
+            j = i + 1;
+            continue;
+        }
+        //a run of consecutive pages, each loaded into its own frame
+        buffers[0] = frameAddress(bminfo, requests[i].frame);
+        count = 1;
+        for(j = i + 1; j < numRequests && count < LOAD_RUN_PAGES; j++){
+            if(requests[j].pageNum == requests[j - 1].pageNum){
+                continue;
+            }
+            if(requests[j].frame == NO_FRAME || requests[j].pageNum != requests[i].pageNum + count){
+                break;
+            }
+            buffers[count++] = frameAddress(bminfo, requests[j].frame);
+        }
+
+        //only grows the file when the pages are beyond the pages we know of
+        lockFile(bminfo, FALSE);
+        extend = fHandle->totalNumPages < requests[i].pageNum + count;
+        unlockFile(bminfo);
+        loaded = RC_OK;
+        if(extend){
+            lockFile(bminfo, TRUE);
+            loaded = ensureCapacity(requests[i].pageNum + count, fHandle);
+            unlockFile(bminfo);
+        }
+        if(loaded == RC_OK){
+            lockFile(bminfo, FALSE);
+            loaded = count == 1 ? readBlock(requests[i].pageNum, fHandle, buffers[0])
+                                : readBlocks(requests[i].pageNum, count, fHandle, buffers);
+            unlockFile(bminfo);
+        }
+
+        for(; i < j; i++){
+            pinRequest *request = &(requests[i]);
+
+            if(request->frame == NO_FRAME){
+                continue;
+            }
+            if(loaded != RC_OK){
+                abandonMiss(bminfo, request->pageNum, request->frame, FALSE, request->moved);
+                request->frame = NO_FRAME;
+                continue;
+            }
+            __atomic_fetch_add(&(bminfo->readTimes), 1, __ATOMIC_RELAXED);
+            //optimistic readers look at the page of the frame only once it is loaded
+            __atomic_store_n(&(bminfo->frameToPage)[request->frame], request->pageNum, __ATOMIC_RELEASE);
+            if(request->moved){
+                endFrameChange(bminfo, request->frame);
+            }
+            releaseFrame(bminfo, request->frame);
+        }
+        status = status == RC_OK ? loaded : status;
+    }
+    return status;
+}
+
+
+/**
+ Initial the buffer pool
+ 
+ - returns: Return the status
+ */
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy,
+                  void *stratData)
+{
+    return initBufferPoolWithOptions(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
+
+/**
+ *  Free everything a pool holds once no thread of it runs any more, the
+ *  page file is closed without writing anything back. Also unwinds a pool
+ *  whose initialization failed after its strategy was set up.
+ *
+ *  @param bm The buffer pool
+ *
+ *  @return The status of closing the page file
+ */
+static RC freeBufferPool(BM_BufferPool *const bm){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    RC status;
+
+    free(bminfo->frames);
+    freeStrategy(bminfo, bm->strategy);
+    status = closePageFile(&(bminfo->fileHandle));
+    freePartitions(bminfo);
+    pthread_mutex_destroy(&(bminfo->prefetchLatch));
+    freeScanRing(bminfo->scanRing);
+    free(bminfo->metadata);
+    munmap(bminfo->arena, bminfo->arenaSize);
+    free(bminfo);
+
+    bm->numPages = 0;
+    return status;
+}
+
+/**
+ Initial the buffer pool with optional settings, NULL options mean the defaults
+ 
+ - returns: Return the status
+ */
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy,
+                  void *stratData, const BM_PoolOptions *options)
+{
+    int openFlags = options ? options->openFlags : SM_OPEN_DEFAULT;
+    int memoryFlags = options ? options->memoryFlags : BM_MEM_DEFAULT;
+    int latchPartitions = options ? options->latchPartitions : 0;
+    //the background writer shares the pool with its users
+    if(options != NULL && options->cleanPercent > 0 && latchPartitions <= 0){
+        latchPartitions = 1;
+    }
+    int pageSize;
+    bufferInfo *bminfo;
+    
+    RC status;
+    if(numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    bminfo = malloc(sizeof(bufferInfo));
+    if(bminfo == NULL){
+        return RC_UNESPECTED_ERROR;
+    }
+    //the page file stays open until the pool is shut down
+    status = openPageFileWithFlags ((char *)pageFileName, &(bminfo->fileHandle), openFlags);
+    if (status != RC_OK){
+        free(bminfo);
+        return status;
+    }
+    //frames are as big as the pages of the file
+    pageSize = getPageSize(&(bminfo->fileHandle));
+    if(options != NULL){
+        setExtentGrowth(&(bminfo->fileHandle), options->growthPercent, options->growthPages);
+    }
+    
+    bm->numPages = numPages;
+    bm->pageFile = (char*) pageFileName;
+    bm->strategy = strategy;
+    bm->mgmtData = bminfo;
+    
+    bminfo->frameNumInBuffer = 0;
+    bminfo->readTimes = 0;
+    bminfo->writeTimes = 0;
+    bminfo->pageSize = pageSize;
+    bminfo->stratData = stratData;
+    
+    if((status = initFrameArena(bminfo, numPages, memoryFlags)) != RC_OK){
+        closePageFile(&(bminfo->fileHandle));
+        free(bminfo);
+        bm->numPages = 0;
+        return status;
+    }
+    bminfo->lfuBuckets = NULL;
+    bminfo->frameBucket = NULL;
+    bminfo->lruK = NULL;
+    bminfo->adaptive = NULL;
+    bminfo->tables = NULL;
+    bminfo->partitionLatches = NULL;
+    if((status = initFrameMetadata(bminfo, numPages)) != RC_OK
+       || (status = initPartitions(bminfo, numPages, latchPartitions)) != RC_OK
+       || (status = initStrategy(bminfo, strategy, numPages, stratData)) != RC_OK){
+        freeStrategy(bminfo, strategy);
+        freePartitions(bminfo);
+        free(bminfo->metadata);
+        munmap(bminfo->arena, bminfo->arenaSize);
+        closePageFile(&(bminfo->fileHandle));
+        free(bminfo);
+        bm->numPages = 0;
+        return status;
+    }
+    
+    //the async engine of prefetchPages is only started when it is used
+    bminfo->prefetchIO = NULL;
+    bminfo->prefetchCompletions = NULL;
+    bminfo->prefetchDepth = options && options->prefetchDepth > 0 ? options->prefetchDepth : 32;
+    if(bminfo->prefetchDepth > numPages){
+        bminfo->prefetchDepth = numPages;
+    }
+    memset(&(bminfo->prefetchStats), 0, sizeof(BM_PrefetchStats));
+    pthread_mutex_init(&(bminfo->prefetchLatch), NULL);
+    
+    bminfo->scanThreshold = 0;
+    bminfo->lastMiss = NO_PAGE;
+    bminfo->missRun = 0;
+    bminfo->scanRing = NULL;
+    bminfo->flushThreads = options && options->flushThreads > 1 ? options->flushThreads : 1;
+    
+    //nothing was pinned yet, so a failure only has to free what was set up
+    bminfo->frames = malloc(sizeof(queue));
+    if(bminfo->frames == NULL){
+        freeBufferPool(bm);
+        return RC_UNESPECTED_ERROR;
+    }
+    //the replacement list starts in frame order
+    bminfo->frames->head = &(bminfo->frameNodes[0]);
+    bminfo->frames->tail = &(bminfo->frameNodes[numPages - 1]);
+    
+    if(options != NULL && options->scanThreshold > 0){
+        if((status = initScanRing(bm, options->scanRingSize, &(bminfo->scanRing))) != RC_OK){
+            freeBufferPool(bm);
+            return status;
+        }
+        bminfo->scanThreshold = options->scanThreshold;
+    }
+    
+    //startWriter leaves writerWindow 0 unless the writer runs
+    if((status = startWriter(bm, options)) != RC_OK){
+        freeBufferPool(bm);
+        return status;
+    }
+    return RC_OK;
+}
+/**
+ *  Shut down the buffer poll
+ *
+ *  @param bm The point pointer to the buffer pool need to shut down
+ *
+ *  @return the status
+ */
+RC shutdownBufferPool(BM_BufferPool *const bm)
+{
+
+    if (bm && bm->numPages > 0) {
+        RC status;
+        //a pool which cannot be written back keeps running, so it can be shut down again
+        status = forceFlushPool(bm);
+        if(status == RC_OK){
+            stopPrefetch((bufferInfo *)bm->mgmtData);
+            stopWriter((bufferInfo *)bm->mgmtData);
+            return freeBufferPool(bm);
+            
+        }
+        else{
+            return status;
+        }
+        
+
+    }
+    else{
+        return RC_INVALID_BM;
+    }
+
+}
+
+/**
+ *  A dirty page forceFlushPool writes back
+ */
+typedef struct dirtyPage{
+    PageNumber pageNum;
+    int frame;
+    long long since;    //when it was first dirtied, to restore it if the write fails
+    bool written;
+}dirtyPage;
+
+/**
+ *  The writes of one forceFlushPool, shared by its threads. runs[i] is the
+ *  index in pages of the first page of run i, runs[numRuns] = numPages.
+ */
+typedef struct flushJob{
+    bufferInfo *info;
+    dirtyPage *pages;
+    int *runs;
+    int numRuns;
+    int nextRun;    //the next run a thread takes
+    RC status;      //the first failure
+}flushJob;
+
+/**
+ *  Order the dirty pages of forceFlushPool by page number
+ *
+ *  @param a A dirtyPage
+ *  @param b A dirtyPage
+ *
+ *  @return <0, 0 or >0 as for qsort
+ */
+static int compareDirtyPages(const void *a, const void *b){
+    PageNumber x = ((const dirtyPage *)a)->pageNum;
+    PageNumber y = ((const dirtyPage *)b)->pageNum;
+
+    return x < y ? -1 : x > y;
+}
+
+/**
+ *  Write a run of dirty pages on consecutive page numbers with one
+ *  writeBlocks. The pages were marked clean before, so a change made
+ *  during the write marks them dirty again.
+ *
+ *  @param info  The information of buffer pool
+ *  @param pages The pages of the run
+ *  @param count The number of pages, at most FLUSH_RUN_PAGES
+ *
+ *  @return The status
+ */
+static RC writeRun(bufferInfo *info, dirtyPage *pages, int count){
+    SM_PageHandle buffers[FLUSH_RUN_PAGES];
+    RC status;
+    int i;
+
+    for(i = 0; i < count; i++){
+        buffers[i] = frameAddress(info, pages[i].frame);
+    }
+    lockFile(info, FALSE);
+    status = writeBlocks(pages[0].pageNum, count, &(info->fileHandle), buffers);
+    unlockFile(info);
+    if(status != RC_OK){
+        return RC_WRITE_FAILED;
+    }
+    for(i = 0; i < count; i++){
+        pages[i].written = TRUE;
+    }
+    __atomic_fetch_add(&(info->writeTimes), count, __ATOMIC_RELAXED);
+    return RC_OK;
+}
+
+/**
+ *  A thread of forceFlushPool, writes runs until none is left
+ *
+ *  @param arg The flushJob
+ *
+ *  @return NULL
+ */
+static void *flushRuns(void *arg){
+    flushJob *job = (flushJob *)arg;
+    int run;
+
+    while((run = __atomic_fetch_add(&(job->nextRun), 1, __ATOMIC_RELAXED)) < job->numRuns){
+        RC status = writeRun(job->info, &(job->pages[job->runs[run]]), job->runs[run + 1] - job->runs[run]);
+        RC expected = RC_OK;
+
+        if(status != RC_OK){
+            __atomic_compare_exchange_n(&(job->status), &expected, status, FALSE,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+/**
+ *  Write back the first maxPages pages of the dirty list, the ones dirtied
+ *  longest ago. They are pinned and sorted by page number, each run of
+ *  consecutive pages is written with one writeBlocks, and with
+ *  BM_PoolOptions.flushThreads > 1 that many threads write the runs.
+ *
+ *  @param bm       The buffer pool
+ *  @param maxPages The most pages written
+ *
+ *  @return The status
+ */
+static RC flushDirtyPages(BM_BufferPool *const bm, int maxPages){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    pthread_t *threads;
+    flushJob job;
+    int numListed = 0;
+    int numPages = 0;
+    int numThreads = 0;
+    int i, frame;
+
+    //pages dirtied from now on are left to the next flush
+    lockDirty(bminfo);
+    if(maxPages > bminfo->numDirty){
+        maxPages = bminfo->numDirty;
+    }
+    unlockDirty(bminfo);
+    if(maxPages <= 0){
+        return RC_OK;
+    }
+    job.info = bminfo;
+    job.pages = malloc(maxPages * sizeof(dirtyPage));
+    job.runs = malloc((maxPages + 1) * sizeof(int));
+    if(job.pages == NULL || job.runs == NULL){
+        free(job.pages);
+        free(job.runs);
+        return RC_UNESPECTED_ERROR;
+    }
+
+    lockDirty(bminfo);
+    for(frame = bminfo->dirtyHead; frame != NO_FRAME && numListed < maxPages; frame = bminfo->dirtyNext[frame]){
+        job.pages[numListed].frame = frame;
+        job.pages[numListed].pageNum = __atomic_load_n(&(bminfo->frameToPage)[frame], __ATOMIC_RELAXED);
+        numListed++;
+    }
+    unlockDirty(bminfo);
+
+    //pinned, so they are not evicted while they are written; frames in I/O are left to their thread
+    for(i = 0; i < numListed; i++){
+        dirtyPage page = job.pages[i];
+
+        if(page.pageNum == NO_PAGE){
+            continue;
+        }
+        lockPartition(bminfo, page.pageNum);
+        if(__atomic_load_n(&(bminfo->frameToPage)[page.frame], __ATOMIC_RELAXED) == page.pageNum
+           && __atomic_load_n(&(bminfo->dirtyFlags)[page.frame], __ATOMIC_RELAXED)
+           && !__atomic_load_n(&(bminfo->ioBusy[page.frame]), __ATOMIC_ACQUIRE)){
+            fixFrame(bminfo, page.frame, 1);
+            job.pages[numPages++] = page;
+        }
+        unlockPartition(bminfo, page.pageNum);
+    }
+
+    qsort(job.pages, numPages, sizeof(dirtyPage), compareDirtyPages);
+    job.numRuns = 0;
+    for(i = 0; i < numPages; i++){
+        if(i == 0 || job.pages[i].pageNum != job.pages[i - 1].pageNum + 1
+           || i - job.runs[job.numRuns - 1] == FLUSH_RUN_PAGES){
+            job.runs[job.numRuns++] = i;
+        }
+        //marked clean before the write, so a change made meanwhile marks it dirty again
+        job.pages[i].since = setClean(bminfo, job.pages[i].frame);
+        job.pages[i].written = FALSE;
+    }
+    job.runs[job.numRuns] = numPages;
+    job.nextRun = 0;
+    job.status = RC_OK;
+
+    //the calling thread writes too
+    threads = NULL;
+    if(bminfo->flushThreads > 1 && job.numRuns > 1){
+        threads = malloc((bminfo->flushThreads - 1) * sizeof(pthread_t));
+    }
+    while(threads != NULL && numThreads < bminfo->flushThreads - 1 && numThreads < job.numRuns - 1
+          && pthread_create(&(threads[numThreads]), NULL, flushRuns, &job) == 0){
+        numThreads++;
+    }
+    flushRuns(&job);
+    for(i = 0; i < numThreads; i++){
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    for(i = 0; i < numPages; i++){
+        if(!job.pages[i].written && job.pages[i].since != 0){
+            setDirty(bminfo, job.pages[i].frame, job.pages[i].since);
+        }
+        lockPartition(bminfo, job.pages[i].pageNum);
+        fixFrame(bminfo, job.pages[i].frame, -1);
+        unlockPartition(bminfo, job.pages[i].pageNum);
+    }
+    free(job.pages);
+    free(job.runs);
+    return job.status;
+}
+
+/**
+ *  write the dirty page back to disk, see flushDirtyPages
+ *
+ *  @param bm A pointer point to bufferpool
+ *
+ *  @return The status
+ */
+
+RC forceFlushPool(BM_BufferPool *const bm)
+{
+    if (bm && bm->numPages > 0){
+        
+        return flushDirtyPages(bm, bm->numPages);
+        
+    }
+    else{
+        return RC_INVALID_BM;
+    }
+    
+
+}
+
+/**
+ *  Write back the pages which have been dirty the longest, for checkpoints
+ *  spread over time
+ *
+ *  @param bm       The buffer pool
+ *  @param maxPages The most pages written
+ *
+ *  @return The status
+ */
+RC flushOldestPages (BM_BufferPool *const bm, int maxPages)
+{
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    return flushDirtyPages(bm, maxPages);
+}
+
+/**
+ *  mark the page writed by user dirty
+ *
+ *  @param bm   The buffer pool
+ *  @param page <#page description#>
+ *
+ *  @return return the status
+ */
+
+RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    if (bm && bm->numPages > 0){
+        
+        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+        int found;
+        
+        /* Locate the page to be marked as dirty.*/
+        lockPartition(bminfo, page->pageNum);
+        found = handleFrame(bm, page);
+        if(found == NO_FRAME){
+            unlockPartition(bminfo, page->pageNum);
+            return RC_NON_EXISTING_PAGE_IN_FRAME;
+        }
+        
+        /* Mark the page as dirty */
+        setDirty(bminfo, found, 0);
+        unlockPartition(bminfo, page->pageNum);
+        
+        return RC_OK;
+        
+
+    }
+    else{
+        
+        return RC_INVALID_BM;
+    }
+    
+
+    
+}
+
+RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    if (bm && bm->numPages > 0){
+        
+        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+        int found;
+        RC status = RC_OK;
+        
+
+        lockPartition(bminfo, page->pageNum);
+        found = handleFrame(bm, page);
+        
+        //unpinPage, so decrease the fixcount.
+        if(found != NO_FRAME && framePinned(bminfo, found)){
+            fixFrame(bminfo, found, -1);
+        }
+        else{
+            status = RC_NON_EXISTING_PAGE_IN_FRAME;
+        }
+        unlockPartition(bminfo, page->pageNum);
+        
+        return status;
+
+        
+
+    }
+    else{
+        return RC_INVALID_BM;
+    }
+    
+
+}
+
+RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
+
+{
+    if (bm && bm->numPages > 0){
+        
+        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+        int found;
+        
+        /* Locate the page to be forced on the disk */
+        lockPartition(bminfo, page->pageNum);
+        found = handleFrame(bm, page);
+        if(found != NO_FRAME){
             
-            frameList->head =NULL;
-            frameList->tail = NULL;
-            free(bminfo->frames);
-            free(bminfo);
+            RC status;
             
-            bm->numPages = 0;
+            //a page in I/O is on disk already or being written back
+            if(__atomic_load_n(&(bminfo->ioBusy[found]), __ATOMIC_ACQUIRE)){
+                unlockPartition(bminfo, page->pageNum);
+                return RC_OK;
+            }
+            fixFrame(bminfo, found, 1);
+            unlockPartition(bminfo, page->pageNum);
             
-            return RC_OK;
+            status = writeFrame(bminfo, found, page->pageNum);
+            
+            lockPartition(bminfo, page->pageNum);
+            fixFrame(bminfo, found, -1);
+            unlockPartition(bminfo, page->pageNum);
+            return status;
             
         }
         else{
-            return status;
+            unlockPartition(bminfo, page->pageNum);
+            return RC_NON_EXISTING_PAGE_IN_FRAME;
         }
-        
 
     }
     else{
         return RC_INVALID_BM;
+    
+    }
+    
+
+}
+
+/**
+ *  Pin a page, loading it into a frame of the ring of a scan on a miss
+ *
+ *  @param bm      The buffer pool
+ *  @param ring    The ring, NULL to use the whole pool
+ *  @param page    The page handle
+ *  @param pageNum The page
+ *
+ *  @return The status
+ */
+static RC pinPageInRing(BM_BufferPool *const bm, BM_ScanRing *ring, BM_PageHandle *const page,
+                        const PageNumber pageNum)
+{
+    RC status;
+    int target;
+    bool firstUse;
+    
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    if(pageNum < 0){
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    pinRequest request;
+    
+    while(1){
+        target = pageInMemo(bm, page, pageNum, &firstUse);
+        if(target != NO_FRAME){
+            //loading a prefetched page counted as its first reference
+            return firstUse ? RC_OK : strategyHit(bminfo, bm->strategy, target);
+        }
+        
+        request.pageNum = pageNum;
+        request.index = 0;
+        request.frame = NO_FRAME;
+        request.moved = FALSE;
+        status = loadPages(bm, ring, &request, 1);
+        if(request.frame != NO_FRAME){
+            setHandle(bminfo, page, pageNum, request.frame);
+            return RC_OK;
+        }
+        if(status != RC_OK){
+            return status;
+        }
+        //another thread loaded the page meanwhile
+    }
+}
+
+
+
+RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
+            const PageNumber pageNum)
+{
+    return pinPageInRing(bm, NULL, page, pageNum);
+}
+
+/**
+ *  A ring of frames for a scan, so that it recycles a few frames of its
+ *  own instead of pushing the working set out of the pool. A ring is used
+ *  by one thread at a time.
+ *
+ *  @param bm   The buffer pool
+ *  @param size The number of frames, 0 = 16; at most a quarter of the pool
+ *  @param ring Set to the ring
+ *
+ *  @return The status
+ */
+RC initScanRing (BM_BufferPool *const bm, int size, BM_ScanRing **ring)
+{
+    BM_ScanRing *scan;
+    int i;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    if(size <= 0){
+        size = 16;
+    }
+    if(size > bm->numPages / 4){
+        size = bm->numPages / 4 > 0 ? bm->numPages / 4 : 1;
+    }
+    scan = malloc(sizeof(BM_ScanRing));
+    if(scan == NULL){
+        return RC_UNESPECTED_ERROR;
+    }
+    scan->frames = malloc(size * sizeof(int));
+    scan->pages = malloc(size * sizeof(PageNumber));
+    if(scan->frames == NULL || scan->pages == NULL){
+        freeScanRing(scan);
+        return RC_UNESPECTED_ERROR;
+    }
+    scan->size = size;
+    scan->next = 0;
+    for(i = 0; i < size; i++){
+        scan->frames[i] = NO_FRAME;
+        scan->pages[i] = NO_PAGE;
+    }
+    *ring = scan;
+    return RC_OK;
+}
+
+/**
+ *  Pin a page for a scan, see initScanRing. Hits are plain pins, misses
+ *  load the page into a frame of the ring.
+ *
+ *  @param bm      The buffer pool
+ *  @param ring    The ring of the scan
+ *  @param page    The page handle
+ *  @param pageNum The page
+ *
+ *  @return The status
+ */
+RC pinPageWithRing (BM_BufferPool *const bm, BM_ScanRing *ring, BM_PageHandle *const page,
+                    const PageNumber pageNum)
+{
+    return pinPageInRing(bm, ring, page, pageNum);
+}
+
+/**
+ *  Free a ring, its frames stay in the pool
+ *
+ *  @param ring The ring
+ *
+ *  @return The status
+ */
+RC freeScanRing (BM_ScanRing *ring)
+{
+    if(ring != NULL){
+        free(ring->frames);
+        free(ring->pages);
+        free(ring);
+    }
+    return RC_OK;
+}
+
+/**
+ *  Pin several pages at once. The pages in the pool are pinned in one pass;
+ *  frames for all the others are taken at once and the missed pages are
+ *  read in order of page number, a run of consecutive pages with one
+ *  vectored read. A page may be asked for more than once, it is pinned
+ *  as many times. If a page cannot be pinned none is.
+ *
+ *  @param bm       The buffer pool
+ *  @param pages    n page handles, pages[i] is set to page pageNums[i]
+ *  @param pageNums The pages
+ *  @param n        The number of pages
+ *
+ *  @return The status
+ */
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages, const PageNumber *pageNums, int n)
+{
+    bufferInfo *bminfo;
+    pinRequest *requests;
+    bool *pinned;
+    bool firstUse;
+    int numRequests = 0;
+    int i, target;
+    RC status = RC_OK;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    if(n <= 0){
+        return RC_OK;
+    }
+    for(i = 0; i < n; i++){
+        if(pageNums[i] < 0){
+            return RC_READ_NON_EXISTING_PAGE;
+        }
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    requests = malloc(n * sizeof(pinRequest));
+    pinned = calloc(n, sizeof(bool));
+    if(requests == NULL || pinned == NULL){
+        free(requests);
+        free(pinned);
+        return RC_UNESPECTED_ERROR;
+    }
+
+    for(i = 0; i < n; i++){
+        target = pageInMemo(bm, &(pages[i]), pageNums[i], &firstUse);
+        if(target != NO_FRAME){
+            pinned[i] = TRUE;
+            if(!firstUse){
+                strategyHit(bminfo, bm->strategy, target);
+            }
+            continue;
+        }
+        requests[numRequests].pageNum = pageNums[i];
+        requests[numRequests].index = i;
+        requests[numRequests].frame = NO_FRAME;
+        requests[numRequests].moved = FALSE;
+        numRequests++;
+    }
+
+    if(numRequests > 0){
+        qsort(requests, numRequests, sizeof(pinRequest), comparePinRequests);
+        status = loadPages(bm, NULL, requests, numRequests);
+        for(i = 0; i < numRequests; i++){
+            pinRequest *request = &(requests[i]);
+            BM_PageHandle *page = &(pages[request->index]);
+
+            if(request->frame != NO_FRAME){
+                setHandle(bminfo, page, request->pageNum, request->frame);
+                pinned[request->index] = TRUE;
+            }
+            //pages loaded by another thread, and the same page asked for again
+            else if(status == RC_OK){
+                status = pinPage(bm, page, request->pageNum);
+                pinned[request->index] = status == RC_OK;
+            }
+        }
+    }
+
+    if(status != RC_OK){
+        for(i = 0; i < n; i++){
+            if(pinned[i]){
+                unpinPage(bm, &(pages[i]));
+            }
+        }
+    }
+    free(requests);
+    free(pinned);
+    return status;
+}
+
+/**
+ *  Unpin several pages
+ *
+ *  @param bm    The buffer pool
+ *  @param pages n page handles
+ *  @param n     The number of pages
+ *
+ *  @return The status of the first page which could not be unpinned
+ */
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages, int n)
+{
+    RC status = RC_OK;
+    int i;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    for(i = 0; i < n; i++){
+        RC unpinned = unpinPage(bm, &(pages[i]));
+
+        if(status == RC_OK){
+            status = unpinned;
+        }
+    }
+    return status;
+}
+
+/**
+ *  Start reading a page into a frame for prefetchPages, the way pinPage does
+ *  on a miss but without waiting for the read or pinning the page. The frame
+ *  stays busy until finishPrefetch. Called with prefetchLatch held.
+ *
+ *  @param bm      The buffer pool
+ *  @param pageNum The page
+ *
+ *  @return The status, RC_OK also when the page is skipped
+ */
+static RC prefetchPage(BM_BufferPool *const bm, const PageNumber pageNum){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    bool beyond, moved;
+    int target;
+    RC status;
+
+    //the pages past the end of the file are not read, a pin would create them
+    lockFile(bminfo, FALSE);
+    beyond = pageNum < 0 || pageNum >= bminfo->fileHandle.totalNumPages;
+    unlockFile(bminfo);
+    if(beyond){
+        bminfo->prefetchStats.skipped++;
+        return RC_OK;
+    }
+    if(__atomic_load_n(&(bminfo->prefetchStats.inFlight), __ATOMIC_RELAXED) == bminfo->prefetchDepth){
+        int n, i;
+
+        status = reapCompletions(bminfo->prefetchIO, bminfo->prefetchCompletions, bminfo->prefetchDepth, 1, &n);
+        if(status != RC_OK){
+            return status;
+        }
+        for(i = 0; i < n; i++){
+            finishPrefetch(bminfo, &(bminfo->prefetchCompletions[i]));
+        }
+    }
+
+    lockStrategy(bminfo);
+    status = claimMissFrame(bm, NULL, pageNum, TRUE, &target);
+    unlockStrategy(bminfo);
+    //a hint is not worth waiting for a frame
+    if(status == RC_NO_MORE_SPACE_IN_BUFFER || (status == RC_OK && target == NO_FRAME)){
+        bminfo->prefetchStats.skipped++;
+        return RC_OK;
+    }
+    if(status != RC_OK){
+        return status;
+    }
+
+    status = evictPage(bminfo, target, &moved);
+    if(status != RC_OK){
+        abandonMiss(bminfo, pageNum, target, TRUE, FALSE);
+        return status;
+    }
+    if(!moved){
+        beginFrameChange(bminfo, target);
+    }
+    __atomic_store_n(&(bminfo->prefetched)[target], TRUE, __ATOMIC_RELAXED);
+    //a mapped file is copied right away, it must not be remapped meanwhile
+    lockFile(bminfo, FALSE);
+    status = submitReadBlock(bminfo->prefetchIO, pageNum, frameAddress(bminfo, target),
+                             (void *)(intptr_t)target);
+    unlockFile(bminfo);
+    if(status != RC_OK){
+        __atomic_store_n(&(bminfo->prefetched)[target], FALSE, __ATOMIC_RELAXED);
+        abandonMiss(bminfo, pageNum, target, TRUE, TRUE);
+        return status;
+    }
+    __atomic_fetch_add(&(bminfo->prefetchStats.inFlight), 1, __ATOMIC_RELAXED);
+    bminfo->prefetchStats.issued++;
+    return RC_OK;
+}
+
+/**
+ *  Start reading pages into the pool without pinning them, so that later
+ *  pins of them are hits. The reads go to the async I/O engine of the pool
+ *  and are collected by the pins of the pages, by later prefetches or when
+ *  every frame is taken. Pages in the pool already, past the end of the
+ *  file or without an unpinned frame to go to are skipped.
+ *
+ *  @param bm       The buffer pool
+ *  @param pageNums The pages, the ones needed first first
+ *  @param n        The number of pages
+ *
+ *  @return The status
+ */
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber *pageNums, int n)
+{
+    bufferInfo *bminfo;
+    RC status = RC_OK;
+    int i;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    reapPrefetches(bminfo, FALSE);
+
+    pthread_mutex_lock(&(bminfo->prefetchLatch));
+    if(bminfo->prefetchIO == NULL){
+        bminfo->prefetchCompletions = malloc(bminfo->prefetchDepth * sizeof(SM_Completion));
+        if(bminfo->prefetchCompletions == NULL){
+            status = RC_UNESPECTED_ERROR;
+        }
+        else if((status = initAsyncIO(&(bminfo->fileHandle), bminfo->prefetchDepth, SM_ASYNC_DEFAULT,
+                                      &(bminfo->prefetchIO))) != RC_OK){
+            //the next call starts over
+            free(bminfo->prefetchCompletions);
+            bminfo->prefetchCompletions = NULL;
+            bminfo->prefetchIO = NULL;
+        }
+    }
+    for(i = 0; i < n && status == RC_OK; i++){
+        bminfo->prefetchStats.requested++;
+        status = prefetchPage(bm, pageNums[i]);
+    }
+    if(bminfo->prefetchIO != NULL){
+        RC submitted = submitAsyncIO(bminfo->prefetchIO);
+
+        if(status == RC_OK){
+            status = submitted;
+        }
+    }
+    pthread_mutex_unlock(&(bminfo->prefetchLatch));
+    return status;
+}
+
+/**
+ *  The frame of a pinned page, for the page latch calls
+ *
+ *  @param bm   The buffer pool
+ *  @param page The page handle
+ *
+ *  @return The frame, NO_FRAME if the page is not pinned in the pool
+ */
+static int pinnedFrame(BM_BufferPool *const bm, BM_PageHandle *const page){
+    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
+    int found;
+
+    lockPartition(bminfo, page->pageNum);
+    found = handleFrame(bm, page);
+    if(found != NO_FRAME && !framePinned(bminfo, found)){
+        found = NO_FRAME;
+    }
+    unlockPartition(bminfo, page->pageNum);
+    return found;
+}
+
+/**
+ *  Latch a pinned page, shared to read it or exclusive to change it. The
+ *  pin keeps the frame in the pool, so the latch is taken without any pool
+ *  latch held and may wait for other threads. A thread must not latch a
+ *  page it holds exclusively again.
+ *
+ *  @param bm   The buffer pool
+ *  @param page The page handle
+ *  @param mode PIN_SHARED or PIN_EXCLUSIVE
+ *
+ *  @return The status
+ */
+RC latchPage (BM_BufferPool *const bm, BM_PageHandle *const page, BM_PinMode mode)
+{
+    int found;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    found = pinnedFrame(bm, page);
+    if(found == NO_FRAME){
+        return RC_NON_EXISTING_PAGE_IN_FRAME;
+    }
+    acquireLatch(&(((bufferInfo *)bm->mgmtData)->pageLatches[found]), mode == PIN_EXCLUSIVE);
+    if(mode == PIN_EXCLUSIVE){
+        beginFrameChange((bufferInfo *)bm->mgmtData, found);
+    }
+    return RC_OK;
+}
+
+/**
+ *  Release the latch of a pinned page
+ *
+ *  @param bm   The buffer pool
+ *  @param page The page handle
+ *  @param mode The mode the page was latched in
+ *
+ *  @return The status, RC_PAGE_NOT_LATCHED if the page is not latched in that mode
+ */
+RC unlatchPage (BM_BufferPool *const bm, BM_PageHandle *const page, BM_PinMode mode)
+{
+    bufferInfo *bminfo;
+    int found;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    found = pinnedFrame(bm, page);
+    if(found == NO_FRAME){
+        return RC_NON_EXISTING_PAGE_IN_FRAME;
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    //only the writer holding the latch can see the exclusive bit set
+    if(mode == PIN_EXCLUSIVE
+       && (__atomic_load_n(&(bminfo->pageLatches[found]), __ATOMIC_RELAXED) & LATCH_EXCLUSIVE)){
+        endFrameChange(bminfo, found);
     }
-
+    return releaseLatch(&(bminfo->pageLatches[found]), mode == PIN_EXCLUSIVE);
 }
 
 /**
- *  write the dirty page back to disk
+ *  Pin a page and latch it
  *
- *  @param bm A pointer point to bufferpool
+ *  @param bm      The buffer pool
+ *  @param page    The page handle
+ *  @param pageNum The page
+ *  @param mode    PIN_SHARED or PIN_EXCLUSIVE
  *
  *  @return The status
  */
-
-RC forceFlushPool(BM_BufferPool *const bm)
+RC pinPageWithMode (BM_BufferPool *const bm, BM_PageHandle *const page,
+                    const PageNumber pageNum, BM_PinMode mode)
 {
-    if (bm && bm->numPages > 0){
-        
-        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
-        frameNode *current = bminfo->frames->head;
-        
-        SM_FileHandle fh;
-        RC status;
-        status =openPageFile ((char *)(bm->pageFile), &fh);
-        if ( status!= RC_OK){
-            return status;
-        }
-        
-        do{
-            if(current->dirtyMark == 1){
-                RC status;
-                status = writeBlock(current->pageNum, &fh, current->data);
-                if( status == RC_OK){
-                    
-                    current->dirtyMark = 0;
-                    (bminfo->writeTimes)++;
-                    (bminfo->readTimes)++;
-                    
-                }
-                else{
-                    return RC_WRITE_FAILED;
-                }
+    RC status = pinPage(bm, page, pageNum);
 
-            }
-            current = current->next;
-        }while(current != NULL);
-        
-        closePageFile(&fh);
-        
-        return RC_OK;
-        
+    if(status != RC_OK){
+        return status;
     }
-    else{
-        return RC_INVALID_BM;
+    if((status = latchPage(bm, page, mode)) != RC_OK){
+        unpinPage(bm, page);
     }
-    
-
+    return status;
 }
 
 /**
- *  mark the page writed by user dirty
+ *  Release the latch of a page and unpin it
  *
  *  @param bm   The buffer pool
- *  @param page <#page description#>
+ *  @param page The page handle
+ *  @param mode The mode the page was pinned in
  *
- *  @return return the status
+ *  @return The status
  */
-
-RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
+RC unpinPageWithMode (BM_BufferPool *const bm, BM_PageHandle *const page, BM_PinMode mode)
 {
-    if (bm && bm->numPages > 0){
-        
-        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
-        frameNode *found;
-        
-        /* Locate the page to be marked as dirty.*/
-        found = findNodewithPageNum(bminfo->frames, page->pageNum);
-        if(found == NULL){
-            return RC_NON_EXISTING_PAGE_IN_FRAME;
-        }
-        
-        /* Mark the page as dirty */
-        found->dirtyMark = 1;
-        
-        return RC_OK;
-        
+    RC status = unlatchPage(bm, page, mode);
 
+    if(status != RC_OK){
+        return status;
     }
-    else{
-        
-        return RC_INVALID_BM;
-    }
-    
-
-    
+    return unpinPage(bm, page);
 }
 
-RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
-{
-    if (bm && bm->numPages > 0){
-        
-        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
-        frameNode *found;
-        
+/**
+ *  The frame of a page for an optimistic read. The frame page->data points
+ *  into is tried first, so a handle which already read the page finds it
+ *  again without writing any shared memory; the page table is searched
+ *  only when the page moved.
+ *
+ *  @param info    The information of buffer pool
+ *  @param page    The page handle
+ *  @param pageNum The page
+ *
+ *  @return The frame, NO_FRAME if the page is not in the pool
+ */
+static int optimisticFrame(bufferInfo *info, BM_PageHandle *const page, const PageNumber pageNum){
+    uintptr_t offset = (uintptr_t)page->data - (uintptr_t)info->arena;
+    int found;
 
-        found = findNodewithPageNum(bminfo->frames, page->pageNum);
-        
-        if(found != NULL){
-            
-            //unpinPage, so decrease the fixcount.
-            if(found->fixCount > 0){
-                found->fixCount--;
-                
-            }
-            else{
-                return RC_NON_EXISTING_PAGE_IN_FRAME;
-            }
-            
-            return RC_OK;
-            
-            
+    if(page->data != NULL && page->pageNum == pageNum
+       && offset < (uintptr_t)info->frameNumInBuffer * info->pageSize
+       && offset % info->pageSize == 0){
+        found = (int)(offset / info->pageSize);
+        if(__atomic_load_n(&(info->frameToPage)[found], __ATOMIC_ACQUIRE) == pageNum){
+            return found;
         }
-        else{
-            return RC_NON_EXISTING_PAGE_IN_FRAME;
-        
-        }
-
-        
-
-    }
-    else{
-        return RC_INVALID_BM;
     }
-    
-
+    lockPartition(info, pageNum);
+    found = findFramewithPageNum(info, pageNum);
+    unlockPartition(info, pageNum);
+    return found;
 }
 
-RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
-
+/**
+ *  Start reading a page without pinning or latching it. The page must be
+ *  in the pool already; page->data may be read until validateOptimisticRead
+ *  says whether what was read is a consistent image of the page. Readers
+ *  are only protected from writers which latch the page PIN_EXCLUSIVE.
+ *  Waits while the page is latched exclusively or being loaded.
+ *
+ *  @param bm      The buffer pool
+ *  @param page    The page handle, a handle which read the page before is fastest
+ *  @param pageNum The page
+ *  @param version Set to the version of the page to validate against
+ *
+ *  @return The status, RC_NON_EXISTING_PAGE_IN_FRAME if the page is not in the
+ *          pool (pin it instead)
+ */
+RC beginOptimisticRead (BM_BufferPool *const bm, BM_PageHandle *const page,
+                        const PageNumber pageNum, unsigned int *version)
 {
-    if (bm && bm->numPages > 0){
-        
-        bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
-        frameNode *found;
-        SM_FileHandle fh;
-        RC status;
-        status =openPageFile ((char *)(bm->pageFile), &fh);
-        if ( status!= RC_OK){
-            return RC_FILE_NOT_FOUND;
-        }
-        
-        /* Locate the page to be forced on the disk */
-        found = findNodewithPageNum(bminfo->frames, page->pageNum);
-        if(found != NULL){
-            
-            RC status;
-            status =writeBlock(found->pageNum, &fh, found->data);
-            
-            if( status == RC_OK){
-                
-                (bminfo->writeTimes)++;
-                
-                closePageFile(&fh);
-                
-                return  RC_OK;
+    bufferInfo *bminfo;
+    int found;
 
-            }
-            closePageFile(&fh);
-            return RC_WRITE_FAILED;
-            
-        }
-        else{
-            closePageFile(&fh);
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    if(pageNum < 0){
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    while(1){
+        found = optimisticFrame(bminfo, page, pageNum);
+        if(found == NO_FRAME){
             return RC_NON_EXISTING_PAGE_IN_FRAME;
         }
-
-    }
-    else{
-        return RC_INVALID_BM;
-    
+        *version = __atomic_load_n(&(bminfo->pageVersions[found]), __ATOMIC_ACQUIRE);
+        //the frame may have been given another page before the version was read
+        if(__atomic_load_n(&(bminfo->frameToPage)[found], __ATOMIC_ACQUIRE) != pageNum){
+            continue;
+        }
+        if((*version & 1) == 0){
+            break;
+        }
+        sched_yield();
     }
-    
-
+    setHandle(bminfo, page, pageNum, found);
+    return RC_OK;
 }
 
-RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
-            const PageNumber pageNum)
+/**
+ *  Check an optimistic read of a page
+ *
+ *  @param bm      The buffer pool
+ *  @param page    The page handle set by beginOptimisticRead
+ *  @param version The version beginOptimisticRead returned
+ *
+ *  @return RC_OK if the page did not change while it was read, else
+ *          RC_READ_CONFLICT and the read has to be done again;
+ *          RC_NON_EXISTING_PAGE_IN_FRAME if the handle does not point at a frame
+ */
+RC validateOptimisticRead (BM_BufferPool *const bm, BM_PageHandle *const page, unsigned int version)
 {
-    RC status;
-    frameNode *target;
-    bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
-    target = pageInMemo(bm, page, pageNum);
-    
-    int currentNumFrame = bminfo->frameNumInBuffer;
-    int totalNumFrame = bm->numPages;
-    
+    bufferInfo *bminfo;
+    uintptr_t offset;
+    int found;
+
     if (!bm || bm->numPages <= 0){
         return RC_INVALID_BM;
     }
-    if(pageNum < 0){
-        return RC_READ_NON_EXISTING_PAGE;
+    bminfo = (bufferInfo *)bm->mgmtData;
+    offset = (uintptr_t)page->data - (uintptr_t)bminfo->arena;
+    if(page->data == NULL || offset >= (uintptr_t)bm->numPages * bminfo->pageSize
+       || offset % bminfo->pageSize != 0){
+        return RC_NON_EXISTING_PAGE_IN_FRAME;
     }
-    
-    switch (bm->strategy)
-    {
-        case RS_FIFO:
-   
-            if(target != NULL){
-                
-                return RC_OK;
-            }
-
-            if (currentNumFrame == totalNumFrame) {
-                
-                target =bminfo->frames->head;
-                while (target->fixCount != 0) {
-                    target = target->next;
-                }
-                
-                if (target == NULL){
-                    return RC_NO_MORE_SPACE_IN_BUFFER;
-                }
-                
-                enQueue(&(bminfo->frames), target);
-            }
-            else{
-                target = bminfo->frames->head;
-                int i = 0;
-                while(i <currentNumFrame){
-                    target = target->next;
-                    ++i;
-                }
-                (bminfo->frameNumInBuffer)++;
-            }
-            
-            status = updateFrame(bm, target, page, pageNum);
-            if(status != RC_OK){
-                return status;
-            }
-            
-            return RC_OK;
-            
-            break;
-        case RS_LRU:
-            
-            if(target != NULL){
-                enQueue(&(bminfo->frames), target);
-                (bminfo->readTimes)++;
-                return RC_OK;
-            }
-            
-            if(currentNumFrame == totalNumFrame){
-                
-                
-                target = bminfo->frames->head;  //从head往tail找
-                
-                while(target->fixCount != 0){
-                    target = target->next;//next
-                }
-                
-                if (target == NULL){
-                    return RC_NO_MORE_SPACE_IN_BUFFER;
-                }
-                enQueue(&(bminfo->frames), target);
-            }
-            else{
-                
-                target = bminfo->frames->head;
-                
-                int i = 0;
-                while(i < currentNumFrame){
-                    target = target->next;
-                    ++i;
-                }
-                (bminfo->frameNumInBuffer)++;
-            }
-            
-            RC status;
-            
-            if((status = updateFrame(bm, target, page, pageNum)) != RC_OK){
-                return status;
-            }
-            
-            
-            return RC_OK;
-            
-            break;
-        default:
-            return RC_UNKNOWN_STRATEGY;
-            break;
+    found = (int)(offset / bminfo->pageSize);
+    //the reads of the page are done before the version is read again
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&(bminfo->pageVersions[found]), __ATOMIC_RELAXED) != version){
+        return RC_READ_CONFLICT;
     }
     return RC_OK;
 }
 
-
-
 PageNumber *getFrameContents (BM_BufferPool *const bm)
 {
     bufferInfo *bminfo = (bufferInfo *)bm->mgmtData;
@@ -620,37 +4045,13 @@ PageNumber *getFrameContents (BM_BufferPool *const bm)
 
 bool *getDirtyFlags (BM_BufferPool *const bm)
 {
-
     bufferInfo *bminfo = bm->mgmtData;
-    frameNode *head =bminfo->frames->head;
-    frameNode *current = head;
-    
-    
-    do{
-        int n = current->frameNum;
-        (bminfo->dirtyFlags)[n] = current->dirtyMark;
-        current = current->next;
-        
-    }while (current != NULL);
-    
     return bminfo->dirtyFlags;
 }
 
 int *getFixCounts (BM_BufferPool *const bm)
 {
-
     bufferInfo *bminfo = bm->mgmtData;
-    frameNode *head =bminfo->frames->head;
-    frameNode *current = head;
-    
-    do{
-        
-        int n = current->frameNum;
-        (bminfo->fixedCounts)[n] = current->fixCount;
-        current = current->next;
-        
-    }while (current != NULL);
-    
     return bminfo->fixedCounts;
 }
 
@@ -667,3 +4068,99 @@ int getNumWriteIO (BM_BufferPool *const bm)
     return bminfo->writeTimes;
 }
 
+
+/**
+ *  The statistics of the background writer. Without a writer only
+ *  dirtyEvictions is counted.
+ *
+ *  @param bm    The buffer pool
+ *  @param stats Set to the statistics
+ *
+ *  @return The status
+ */
+RC getWriterStats (BM_BufferPool *const bm, BM_WriterStats *stats)
+{
+    bufferInfo *bminfo;
+    struct timespec now;
+    double seconds;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    if(bminfo->writerWindow == 0){
+        memset(stats, 0, sizeof(BM_WriterStats));
+        stats->dirtyEvictions = __atomic_load_n(&(bminfo->writerStats.dirtyEvictions), __ATOMIC_RELAXED);
+        return RC_OK;
+    }
+    pthread_mutex_lock(&(bminfo->writerLatch));
+    *stats = bminfo->writerStats;
+    pthread_mutex_unlock(&(bminfo->writerLatch));
+    stats->dirtyEvictions = __atomic_load_n(&(bminfo->writerStats.dirtyEvictions), __ATOMIC_RELAXED);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    seconds = (now.tv_sec - bminfo->writerStart.tv_sec) + (now.tv_nsec - bminfo->writerStart.tv_nsec) / 1e9;
+    stats->pagesPerSecond = seconds > 0 ? stats->pagesWritten / seconds : 0;
+    return RC_OK;
+}
+
+/**
+ *  The number of dirty pages and the age of the oldest one, from the
+ *  dirty list
+ *
+ *  @param bm    The buffer pool
+ *  @param stats Set to the statistics
+ *
+ *  @return The status
+ */
+RC getDirtyStats (BM_BufferPool *const bm, BM_DirtyStats *stats)
+{
+    bufferInfo *bminfo;
+    long long oldest = 0;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    lockDirty(bminfo);
+    stats->dirtyPages = bminfo->numDirty;
+    if(bminfo->dirtyHead != NO_FRAME){
+        oldest = bminfo->dirtySince[bminfo->dirtyHead];
+    }
+    unlockDirty(bminfo);
+    stats->oldestDirtyMs = oldest != 0 ? (monotonicNs() - oldest) / 1e6 : 0;
+    return RC_OK;
+}
+
+/**
+ *  The statistics of prefetchPages
+ *
+ *  @param bm    The buffer pool
+ *  @param stats Set to the statistics
+ *
+ *  @return The status
+ */
+RC getPrefetchStats (BM_BufferPool *const bm, BM_PrefetchStats *stats)
+{
+    bufferInfo *bminfo;
+
+    if (!bm || bm->numPages <= 0){
+        return RC_INVALID_BM;
+    }
+    bminfo = (bufferInfo *)bm->mgmtData;
+    pthread_mutex_lock(&(bminfo->prefetchLatch));
+    stats->requested = bminfo->prefetchStats.requested;
+    stats->issued = bminfo->prefetchStats.issued;
+    stats->skipped = bminfo->prefetchStats.skipped;
+    stats->completed = bminfo->prefetchStats.completed;
+    pthread_mutex_unlock(&(bminfo->prefetchLatch));
+    stats->used = __atomic_load_n(&(bminfo->prefetchStats.used), __ATOMIC_RELAXED);
+    stats->unused = __atomic_load_n(&(bminfo->prefetchStats.unused), __ATOMIC_RELAXED);
+    stats->inFlight = __atomic_load_n(&(bminfo->prefetchStats.inFlight), __ATOMIC_RELAXED);
+    return RC_OK;
+}
+
+int getPoolPageSize (BM_BufferPool *const bm)
+{
+    bufferInfo *bminfo = bm->mgmtData;
+    return bminfo->pageSize;
+}
@@ -8,12 +8,18 @@
 #include "dt.h"
 
 // Replacement Strategies
+// stratData of initBufferPool:
+//   RS_LFU  int * : halve all reference counts every this many pins, NULL = no aging
+//   RS_LRU_K int * : K, the number of references remembered per page (default 2)
+//   RS_2Q   int * : size of the A1in queue in percent of the pool (default 25)
 typedef enum ReplacementStrategy {
   RS_FIFO = 0,
   RS_LRU = 1,
   RS_CLOCK = 2,
   RS_LFU = 3,
-  RS_LRU_K = 4
+  RS_LRU_K = 4,
+  RS_ARC = 5,
+  RS_2Q = 6
 } ReplacementStrategy;
 
 // Data Types and Structures
@@ -31,21 +37,86 @@ typedef struct BM_BufferPool {
 typedef struct BM_PageHandle {
   PageNumber pageNum;
   char *data;
+  int frame;                // set by pinPage, so unpinPage, markDirty and forcePage
+  unsigned int generation;  // find the frame without a lookup while it holds the page
 } BM_PageHandle;
 
+// Optional settings of a buffer pool, see initBufferPoolWithOptions
+typedef struct BM_PoolOptions {
+  int openFlags;      // SM_OPEN_* flags the page file is opened with
+  int growthPercent;  // extent growth policy of the page file, see setExtentGrowth
+  int growthPages;
+  int memoryFlags;    // BM_MEM_* flags of the frame memory
+  int latchPartitions; // > 0 makes the pool thread-safe, its page table split into
+                       // this many latched partitions; 0 = used by one thread
+  int cleanPercent;    // > 0 starts a background writer which keeps this percentage of
+                       // the frames next in line for eviction clean (makes the pool thread-safe)
+  int writerIntervalMs; // how often the writer looks at them, 0 = every 10 ms
+  int prefetchDepth;   // the most prefetchPages reads outstanding at once, 0 = 32
+  int scanThreshold;   // > 0: after this many misses on consecutive pages, the misses of
+                       // the run go to a ring of frames of the pool (see initScanRing)
+  int scanRingSize;    // the frames of that ring, 0 = 16
+  int flushThreads;    // threads forceFlushPool writes with, 0 = the calling thread only
+} BM_PoolOptions;
+
+// A small ring of frames a scan recycles, see initScanRing
+typedef struct BM_ScanRing BM_ScanRing;
+
+// Statistics of the background writer, see getWriterStats
+typedef struct BM_WriterStats {
+  int pagesWritten;      // pages the writer wrote back ahead of eviction
+  int rounds;            // times it looked at the eviction candidates
+  int queueLength;       // dirty candidates it found in its last round
+  int maxQueueLength;
+  int dirtyEvictions;    // misses which had to write a dirty victim themselves
+  double pagesPerSecond; // pagesWritten over the time the writer has run
+} BM_WriterStats;
+
+// Statistics of prefetchPages, see getPrefetchStats
+typedef struct BM_PrefetchStats {
+  int requested;         // pages asked for
+  int issued;            // reads started
+  int skipped;           // pages in the pool already, past the end of the file or without a frame
+  int completed;         // reads done
+  int used;              // prefetched pages pinned before they were evicted
+  int unused;            // prefetched pages evicted without a pin
+  int inFlight;          // reads not collected yet
+} BM_PrefetchStats;
+
+// Dirty pages of a pool, see getDirtyStats
+typedef struct BM_DirtyStats {
+  int dirtyPages;        // pages changed since they were last written
+  double oldestDirtyMs;  // how long the page dirtied first has been dirty, 0 if none is
+} BM_DirtyStats;
+
+/* memoryFlags of BM_PoolOptions */
+#define BM_MEM_DEFAULT 0
+#define BM_MEM_HUGEPAGES 1  // back the frames with huge pages where possible
+#define BM_MEM_LOCK 2       // mlock the frames, see RC_MEMORY_LOCK_FAILED
+
+// Latch modes of a pinned page: readers share the page, a writer has it alone
+typedef enum BM_PinMode {
+  PIN_SHARED = 0,
+  PIN_EXCLUSIVE = 1
+} BM_PinMode;
+
 // convenience macros
 #define MAKE_POOL()					\
   ((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
 
 #define MAKE_PAGE_HANDLE()				\
-  ((BM_PageHandle *) malloc (sizeof(BM_PageHandle)))
+  ((BM_PageHandle *) calloc (1, sizeof(BM_PageHandle)))
 
 // Buffer Manager Interface Pool Handling
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		  const int numPages, ReplacementStrategy strategy, 
 		  void *stratData);
+RC initBufferPoolWithOptions(BM_BufferPool *const bm, const char *const pageFileName, 
+		  const int numPages, ReplacementStrategy strategy, 
+		  void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC flushOldestPages (BM_BufferPool *const bm, int maxPages);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -53,6 +124,21 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 	    const PageNumber pageNum);
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages, const PageNumber *pageNums, int n);
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages, int n);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber *pageNums, int n);
+RC initScanRing (BM_BufferPool *const bm, int size, BM_ScanRing **ring);
+RC pinPageWithRing (BM_BufferPool *const bm, BM_ScanRing *ring, BM_PageHandle *const page,
+		    const PageNumber pageNum);
+RC freeScanRing (BM_ScanRing *ring);
+RC pinPageWithMode (BM_BufferPool *const bm, BM_PageHandle *const page,
+		    const PageNumber pageNum, BM_PinMode mode);
+RC unpinPageWithMode (BM_BufferPool *const bm, BM_PageHandle *const page, BM_PinMode mode);
+RC latchPage (BM_BufferPool *const bm, BM_PageHandle *const page, BM_PinMode mode);
+RC unlatchPage (BM_BufferPool *const bm, BM_PageHandle *const page, BM_PinMode mode);
+RC beginOptimisticRead (BM_BufferPool *const bm, BM_PageHandle *const page,
+			const PageNumber pageNum, unsigned int *version);
+RC validateOptimisticRead (BM_BufferPool *const bm, BM_PageHandle *const page, unsigned int version);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,5 +146,9 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getPoolPageSize (BM_BufferPool *const bm);
+RC getWriterStats (BM_BufferPool *const bm, BM_WriterStats *stats);
+RC getPrefetchStats (BM_BufferPool *const bm, BM_PrefetchStats *stats);
+RC getDirtyStats (BM_BufferPool *const bm, BM_DirtyStats *stats);
 
 #endif
@@ -38,6 +38,15 @@ typedef int RC;
 #define RC_PAGE_OUTOF_RANGE 103
 #define RC_NO_SUCH_PAGE_IN_BUFF 104
 #define RC_UNESPECTED_ERROR 105
+#define RC_MAP_FAILED 106
+#define RC_DIRECT_IO_FAILED 107
+#define RC_ASYNC_IO_FAILED 108
+#define RC_ASYNC_QUEUE_FULL 109
+#define RC_INVALID_PAGE_SIZE 110
+#define RC_INVALID_FILE_HEADER 111
+#define RC_MEMORY_LOCK_FAILED 112
+#define RC_PAGE_NOT_LATCHED 113
+#define RC_READ_CONFLICT 114
 /* holder for error messages */
 extern char *RC_message;
 
@@ -1,13 +1,399 @@
+#ifdef __linux__
+#define _GNU_SOURCE     //for mremap and O_DIRECT
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <pthread.h>
 #include "storage_mgr.h"
 #include "dberror.h"
 
+/**
+ *  The information of an open page file kept in fHandle->mgmtInfo
+ */
+typedef struct SM_FileInfo{
+    int fd;
+    int flags;
+    int pageSize;       //from the header page
+    char *map;          //the mapping of the whole file in SM_OPEN_MMAP mode
+    size_t mapSize;
+    int growthPercent;  //extent growth policy, see setExtentGrowth
+    int growthPages;
+    int reservedPages;  //pages the file has room for, the end of its last extent
+    int headerPages;    //the page count in the header page
+}SM_FileInfo;
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SM_HAVE_URING
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+/**
+ *  The header at the start of every page file. The header takes the first
+ *  pageSize bytes of the file, so page n starts at (n + 1) * pageSize and
+ *  the pages keep their alignment for direct I/O.
+ */
+#define SM_FILE_MAGIC "CS525PF"
+#define SM_FILE_VERSION 1
+
+typedef struct SM_FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t pageSize;
+    uint32_t pageCount;
+}SM_FileHeader;
+
 void initStorageManager (void){
 }
 
+/*
+*******************  I/O Helpers  *************************
+*/
+
+/**
+ *  Read len bytes at offset, retrying on short reads and interrupts
+ *
+ *  @param fd     The file descriptor
+ *  @param buf    Where the bytes are saved
+ *  @param len    The number of bytes to read
+ *  @param offset The position in the file
+ *
+ *  @return RC_OK, or RC_READ_FAIL if the file ends early or the read fails
+ */
+static RC readFully(int fd, char *buf, size_t len, off_t offset){
+    size_t done = 0;
+
+    while(done < len){
+        ssize_t n = pread(fd, buf + done, len - done, offset + done);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return RC_READ_FAIL;
+        }
+        if(n == 0){
+            return RC_READ_FAIL;
+        }
+        done += n;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Write len bytes at offset, retrying on short writes and interrupts
+ *
+ *  @param fd     The file descriptor
+ *  @param buf    The bytes to write
+ *  @param len    The number of bytes to write
+ *  @param offset The position in the file
+ *
+ *  @return RC_OK, or RC_WRITE_FAILED
+ */
+static RC writeFully(int fd, const char *buf, size_t len, off_t offset){
+    size_t done = 0;
+
+    while(done < len){
+        ssize_t n = pwrite(fd, buf + done, len - done, offset + done);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return RC_WRITE_FAILED;
+        }
+        done += n;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Page sizes are powers of two from SM_MIN_PAGE_SIZE to SM_MAX_PAGE_SIZE
+ *
+ *  @param pageSize The page size
+ *
+ *  @return 1 if the page size can be used
+ */
+static int validPageSize(int pageSize){
+    return pageSize >= SM_MIN_PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
+}
+
+/**
+ *  The position of a page in the file, behind the header page
+ *
+ *  @param info    The information of the open file
+ *  @param pageNum The page
+ *
+ *  @return the offset in bytes
+ */
+static off_t pageOffset(SM_FileInfo *info, int pageNum){
+    return (off_t)(pageNum + 1) * info->pageSize;
+}
+
+/**
+ *  Write the header block. It is SM_DIRECT_IO_ALIGN bytes from an aligned
+ *  buffer, so it can be written in SM_OPEN_DIRECT mode too.
+ *
+ *  @param fd        The file descriptor
+ *  @param pageSize  The page size of the file
+ *  @param pageCount The number of pages in the file
+ *
+ *  @return RC_OK or RC_WRITE_FAILED
+ */
+static RC writeHeader(int fd, int pageSize, int pageCount){
+    SM_FileHeader header;
+    void *block;
+    RC status;
+
+    if(posix_memalign(&block, SM_DIRECT_IO_ALIGN, SM_DIRECT_IO_ALIGN) != 0){
+        return RC_WRITE_FAILED;
+    }
+    memset(block, 0, SM_DIRECT_IO_ALIGN);
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SM_FILE_MAGIC, sizeof(header.magic));
+    header.version = SM_FILE_VERSION;
+    header.pageSize = (uint32_t)pageSize;
+    header.pageCount = (uint32_t)pageCount;
+    memcpy(block, &header, sizeof(header));
+    status = writeFully(fd, block, SM_DIRECT_IO_ALIGN, 0);
+    free(block);
+    return status;
+}
+
+/**
+ *  Read and check the header block
+ *
+ *  @param fd     The file descriptor
+ *  @param header Where the header is saved
+ *
+ *  @return RC_OK, or RC_INVALID_FILE_HEADER if the file is not a page file of this version
+ */
+static RC readHeader(int fd, SM_FileHeader *header){
+    void *block;
+    RC status;
+
+    if(posix_memalign(&block, SM_DIRECT_IO_ALIGN, SM_DIRECT_IO_ALIGN) != 0){
+        return RC_READ_FAIL;
+    }
+    status = readFully(fd, block, SM_DIRECT_IO_ALIGN, 0);
+    memcpy(header, block, sizeof(*header));
+    free(block);
+    if(status != RC_OK || memcmp(header->magic, SM_FILE_MAGIC, sizeof(header->magic)) != 0
+       || header->version != SM_FILE_VERSION || !validPageSize((int)header->pageSize)
+       || header->pageCount > INT_MAX){
+        return RC_INVALID_FILE_HEADER;
+    }
+    return RC_OK;
+}
+
+/**
+ *  Read or write a vector of buffers at offset with preadv/pwritev,
+ *  retrying on short transfers and interrupts. The iovec array is consumed.
+ *
+ *  @param fd      The file descriptor
+ *  @param iov     The buffers
+ *  @param iovcnt  The number of buffers
+ *  @param offset  The position in the file
+ *  @param isWrite 1 to write, 0 to read
+ *
+ *  @return RC_OK, RC_READ_FAIL or RC_WRITE_FAILED
+ */
+static RC transferVector(int fd, struct iovec *iov, int iovcnt, off_t offset, int isWrite){
+    int index = 0;
+
+    while(index < iovcnt){
+        int batch = iovcnt - index < IOV_MAX ? iovcnt - index : IOV_MAX;
+        ssize_t n = isWrite ? pwritev(fd, iov + index, batch, offset) : preadv(fd, iov + index, batch, offset);
+
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return isWrite ? RC_WRITE_FAILED : RC_READ_FAIL;
+        }
+        if(n == 0){
+            return isWrite ? RC_WRITE_FAILED : RC_READ_FAIL;
+        }
+        offset += n;
+        //skip the buffers which are done and trim a partly done one
+        while(n > 0){
+            if((size_t)n >= iov[index].iov_len){
+                n -= iov[index].iov_len;
+                index++;
+            }
+            else{
+                iov[index].iov_base = (char *)iov[index].iov_base + n;
+                iov[index].iov_len -= n;
+                n = 0;
+            }
+        }
+    }
+    return RC_OK;
+}
+
+/**
+ *  Read one page. In SM_OPEN_DIRECT mode a page buffer which is not
+ *  aligned to SM_DIRECT_IO_ALIGN goes through an aligned bounce buffer.
+ *
+ *  @param info    The information of the open file
+ *  @param pageNum The page to read
+ *  @param memPage Where the page is saved
+ *
+ *  @return RC_OK or RC_READ_FAIL
+ */
+static RC readPage(SM_FileInfo *info, int pageNum, char *memPage){
+    off_t offset = pageOffset(info, pageNum);
+    void *bounce;
+    RC status;
+
+    if(!(info->flags & SM_OPEN_DIRECT) || (uintptr_t)memPage % SM_DIRECT_IO_ALIGN == 0){
+        return readFully(info->fd, memPage, info->pageSize, offset);
+    }
+    if(posix_memalign(&bounce, SM_DIRECT_IO_ALIGN, info->pageSize) != 0){
+        return RC_READ_FAIL;
+    }
+    if((status = readFully(info->fd, bounce, info->pageSize, offset)) == RC_OK){
+        memcpy(memPage, bounce, info->pageSize);
+    }
+    free(bounce);
+    return status;
+}
+
+/**
+ *  Write one page, see readPage for the alignment rules
+ *
+ *  @param info    The information of the open file
+ *  @param pageNum The page to write
+ *  @param memPage The content of the page
+ *
+ *  @return RC_OK or RC_WRITE_FAILED
+ */
+static RC writePage(SM_FileInfo *info, int pageNum, const char *memPage){
+    off_t offset = pageOffset(info, pageNum);
+    void *bounce;
+    RC status;
+
+    if(!(info->flags & SM_OPEN_DIRECT) || (uintptr_t)memPage % SM_DIRECT_IO_ALIGN == 0){
+        return writeFully(info->fd, memPage, info->pageSize, offset);
+    }
+    if(posix_memalign(&bounce, SM_DIRECT_IO_ALIGN, info->pageSize) != 0){
+        return RC_WRITE_FAILED;
+    }
+    memcpy(bounce, memPage, info->pageSize);
+    status = writeFully(info->fd, bounce, info->pageSize, offset);
+    free(bounce);
+    return status;
+}
+
+/**
+ *  Map numPages pages of the file and the header page, replacing the old mapping if there is one
+ *
+ *  @param info     The information of the open file
+ *  @param numPages The number of pages to map
+ *
+ *  @return RC_OK or RC_MAP_FAILED
+ */
+static RC remapFile(SM_FileInfo *info, int numPages){
+    size_t newSize = (size_t)(numPages + 1) * info->pageSize;
+    char *map;
+
+    if(newSize == info->mapSize){
+        return RC_OK;
+    }
+    if(info->map == NULL){
+        map = newSize ? mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, info->fd, 0) : NULL;
+    }
+#ifdef __linux__
+    else{
+        map = mremap(info->map, info->mapSize, newSize, MREMAP_MAYMOVE);
+    }
+#else
+    else{
+        munmap(info->map, info->mapSize);
+        map = mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, info->fd, 0);
+    }
+#endif
+    if(map == MAP_FAILED){
+        info->map = NULL;
+        info->mapSize = 0;
+        return RC_MAP_FAILED;
+    }
+    info->map = map;
+    info->mapSize = newSize;
+    return RC_OK;
+}
+
+/**
+ *  Grow the file to numPages zero filled pages. Without an extent growth
+ *  policy the size is set with one ftruncate, so the new pages are a hole
+ *  until they are written. With one the file grows by a whole extent, with
+ *  its blocks allocated by fallocate where the file system offers it, and
+ *  the following appends within the extent only count the page. The
+ *  header page is written when an extent is added and when the file is
+ *  closed, which also cuts the file back to its last page.
+ *
+ *  @param fHandle  The structure incloud the info of file
+ *  @param numPages The number of pages the file will have
+ *
+ *  @return success or fail
+ */
+static RC growFile(SM_FileHandle *fHandle, int numPages){
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    long long target = numPages;
+    int allocated = 0;
+    RC status;
+
+    if(numPages <= info->reservedPages){
+        fHandle->totalNumPages = numPages;
+        return RC_OK;
+    }
+    if(info->growthPercent > 0 || info->growthPages > 0){
+        target = fHandle->totalNumPages + (long long)fHandle->totalNumPages * info->growthPercent / 100;
+        if(target < fHandle->totalNumPages + (long long)info->growthPages){
+            target = fHandle->totalNumPages + (long long)info->growthPages;
+        }
+        if(target < numPages){
+            target = numPages;
+        }
+        if(target > INT_MAX){
+            target = INT_MAX;
+        }
+    }
+
+#ifdef __linux__
+    //a file system without fallocate gets the extent as a hole
+    if(target > numPages){
+        allocated = fallocate(info->fd, 0, pageOffset(info, info->reservedPages),
+                              (off_t)(target - info->reservedPages) * info->pageSize) == 0;
+    }
+#endif
+    //the file system fills the new pages with zeros
+    if(!allocated && ftruncate(info->fd, pageOffset(info, (int)target)) != 0){
+        return RC_WRITE_FAILED;
+    }
+    info->reservedPages = (int)target;
+    if((status = writeHeader(info->fd, info->pageSize, numPages)) != RC_OK){
+        return status;
+    }
+    info->headerPages = numPages;
+    //the mapping covers the extent, so appends within it need no remap
+    if((info->flags & SM_OPEN_MMAP) && (status = remapFile(info, info->reservedPages)) != RC_OK){
+        return status;
+    }
+    fHandle->totalNumPages = numPages;
+    return RC_OK;
+}
+
 /*
 *******************  Page Functions  *************************
 */
@@ -20,24 +406,40 @@ void initStorageManager (void){
  */
 
 RC createPageFile (char *fileName){
+    return createPageFileWithPageSize(fileName, PAGE_SIZE);
+}
+
+/**
+ *  Create a page file with one empty page of pageSize bytes. The page size
+ *  is kept in the header page and used by everyone who opens the file.
+ *
+ *  @param fileName The name of file
+ *  @param pageSize A power of two from SM_MIN_PAGE_SIZE to SM_MAX_PAGE_SIZE
+ *
+ *  @return Return the status
+ */
+RC createPageFileWithPageSize (char *fileName, int pageSize){
 
     if(fileName==NULL){
         return RC_FILE_NOT_FOUND;
     }
+    if(!validPageSize(pageSize)){
+        return RC_INVALID_PAGE_SIZE;
+    }
     //create the file
-    FILE *file=fopen(fileName,"w+");
-    //fill the block with '/0'
-    if(file)
+    int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd >= 0)
     {
-        char firstPage[PAGE_SIZE];
-        memset(firstPage,'\0',PAGE_SIZE);
-        //The first page of file is zero
-        long result=fwrite(firstPage, sizeof(char), PAGE_SIZE, file);
-        
-        fclose(file);
-        return RC_OK;
+        //the header and the first page, which is zero
+        RC status = writeHeader(fd, pageSize, 1);
+        if(status == RC_OK && ftruncate(fd, (off_t)2 * pageSize) != 0){
+            status = RC_WRITE_FAILED;
+        }
+
+        close(fd);
+        return status;
     }
-    
+
     return RC_FILE_NOT_FOUND;
 
 }
@@ -51,22 +453,86 @@ RC createPageFile (char *fileName){
  *  @return return the status of function
  */
 RC openPageFile (char *fileName, SM_FileHandle *fHandle){
-    
-    FILE *pagef = fopen(fileName, "r+");
-
-    
-    if(pagef){
-        int flag = fseek(pagef,0L,SEEK_END);
-        long filesize=0;
-        filesize = (ftell(pagef)+1)/PAGE_SIZE;
+    return openPageFileWithFlags(fileName, fHandle, SM_OPEN_DEFAULT);
+}
+
+/**
+ *  Open a file with the given SM_OPEN_* flags. The page size and the number of
+ *  pages come from the header page.
+ *  With SM_OPEN_MMAP the whole file is mapped and pages are copied from and to the mapping.
+ *  With SM_OPEN_DIRECT pages bypass the kernel page cache (O_DIRECT, or F_NOCACHE where
+ *  O_DIRECT does not exist). SM_OPEN_DIRECT is ignored together with SM_OPEN_MMAP.
+ *
+ *  @param fileName This is the name of file
+ *  @param fHandle  Save open file's information
+ *  @param flags    The SM_OPEN_* flags
+ *
+ *  @return return the status of function
+ */
+RC openPageFileWithFlags (char *fileName, SM_FileHandle *fHandle, int flags){
+
+    int openFlags = O_RDWR;
+
+    if(flags & SM_OPEN_MMAP){
+        flags &= ~SM_OPEN_DIRECT;
+    }
+#ifdef O_DIRECT
+    if(flags & SM_OPEN_DIRECT){
+        openFlags |= O_DIRECT;
+    }
+#endif
+    int fd = open(fileName, openFlags);
+    if(fd < 0 && (flags & SM_OPEN_DIRECT) && errno == EINVAL){
+        //the file system does not support direct I/O
+        return RC_DIRECT_IO_FAILED;
+    }
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if(fd >= 0 && (flags & SM_OPEN_DIRECT) && fcntl(fd, F_NOCACHE, 1) != 0){
+        close(fd);
+        return RC_DIRECT_IO_FAILED;
+    }
+#endif
+
+    if(fd >= 0){
+        SM_FileHeader header;
+        struct stat st;
+        RC status = readHeader(fd, &header);
+        //the pages the header counts have to be in the file
+        if(status == RC_OK && (fstat(fd, &st) != 0
+                               || st.st_size < (off_t)(header.pageCount + 1) * header.pageSize)){
+            status = RC_INVALID_FILE_HEADER;
+        }
+        if(status != RC_OK){
+            close(fd);
+            return status;
+        }
+        SM_FileInfo *info = malloc(sizeof(SM_FileInfo));
+        if(info == NULL){
+            close(fd);
+            return RC_FILE_HANDLE_NOT_INIT;
+        }
+        info->fd = fd;
+        info->flags = flags;
+        info->pageSize = (int)header.pageSize;
+        info->map = NULL;
+        info->mapSize = 0;
+        info->growthPercent = 0;
+        info->growthPages = 0;
+        info->reservedPages = (int)header.pageCount;
+        info->headerPages = (int)header.pageCount;
+        if((flags & SM_OPEN_MMAP) && remapFile(info, (int)header.pageCount) != RC_OK){
+            close(fd);
+            free(info);
+            return RC_MAP_FAILED;
+        }
         fHandle->fileName = fileName;
-        fHandle->totalNumPages = filesize;
+        fHandle->totalNumPages = (int)header.pageCount;
         fHandle->curPagePos = 0;
-        fHandle->mgmtInfo = pagef;
+        fHandle->mgmtInfo = info;
         return RC_OK;
     }
     return RC_FILE_NOT_FOUND;
-    
+
 
 
 }
@@ -78,12 +544,31 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle){
  *  @return return the status of function
  */
 RC closePageFile (SM_FileHandle *fHandle){
-    
-    
-    if (fclose(fHandle->mgmtInfo)==0) {
-        return RC_OK;
+
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    RC status = RC_OK;
+
+    if (info == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;
     }
-    return RC_FILE_NOT_FOUND;
+    if (info->map != NULL) {
+        munmap(info->map, info->mapSize);
+    }
+    //the rest of the last extent is given back and the header gets the appends within it
+    if(info->reservedPages > fHandle->totalNumPages
+       && ftruncate(info->fd, pageOffset(info, fHandle->totalNumPages)) != 0){
+        status = RC_WRITE_FAILED;
+    }
+    if(info->headerPages != fHandle->totalNumPages && status == RC_OK){
+        status = writeHeader(info->fd, info->pageSize, fHandle->totalNumPages);
+    }
+    int check = close(info->fd);
+    free(info);
+    fHandle->mgmtInfo = NULL;
+    if (check != 0) {
+        return RC_FILE_NOT_FOUND;
+    }
+    return status;
 
 }
 
@@ -102,7 +587,7 @@ RC destroyPageFile (char *fileName){
   }
 
   return RC_FILE_NOT_FOUND;
-    
+
 }
 
 /*
@@ -110,7 +595,9 @@ RC destroyPageFile (char *fileName){
 */
 
 /**
- *  the readBlock function reads page from the selected file into the memory pointed by SM_PageHandle
+ *  the readBlock function reads page from the selected file into the memory pointed by SM_PageHandle.
+ *  It reads at a fixed position and does not touch curPagePos, so several threads can read through
+ *  the same handle at once.
  *
  *  @param pageNum indicates the page number user want to read
  *  @param fHandle saves opend file's infomation
@@ -120,27 +607,22 @@ RC destroyPageFile (char *fileName){
  */
 RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
-    if(fHandle)
+    if(fHandle && fHandle->mgmtInfo)
     {
-        if(pageNum>fHandle->totalNumPages||pageNum<0)
+        if(pageNum>=fHandle->totalNumPages||pageNum<0)
         {
             return RC_READ_NON_EXISTING_PAGE;
         }
 
-        int setPointer = fseek(fHandle->mgmtInfo, PAGE_SIZE*(pageNum), SEEK_SET);
-        if(setPointer==-1){
-            return RC_CANNT_SET_POINTER;
+        SM_FileInfo *info = fHandle->mgmtInfo;
+        if(info->map != NULL){
+            memcpy(memPage, info->map + pageOffset(info, pageNum), info->pageSize);
+            return RC_OK;
         }
-        size_t flag = fread(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
+        return readPage(info, pageNum, memPage);
 
-        if(flag == 0){
-            return RC_READ_FAIL;
-        }
-        fHandle->curPagePos=pageNum;
-        return RC_OK;
-    
     }
-    return RC_READ_FAIL;
+    return RC_FILE_HANDLE_NOT_INIT;
 
 }
 
@@ -157,6 +639,67 @@ int getBlockPos (SM_FileHandle *fHandle)
     return fHandle->curPagePos;
 }
 
+/**
+ *  the page size of an open file, every page buffer of the file needs this many bytes
+ *
+ *  @param fHandle saves opend file's infomation
+ *
+ *  @return the page size in bytes, or -1 if the file is not open
+ */
+
+int getPageSize (SM_FileHandle *fHandle)
+{
+    if(fHandle == NULL || fHandle->mgmtInfo == NULL){
+        return -1;
+    }
+    return ((SM_FileInfo *)fHandle->mgmtInfo)->pageSize;
+}
+
+/**
+ *  Hand out a pointer to a page inside the mapping instead of copying it.
+ *  Only works for files opened with SM_OPEN_MMAP. The pointer stays valid
+ *  until the file grows or is closed.
+ *
+ *  @param pageNum the page user want to read
+ *  @param fHandle saves opend file's infomation
+ *  @param page    where the pointer to the page is saved
+ *
+ *  @return RC_OK indicates success
+ */
+RC getBlockPointer (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *page)
+{
+    if(fHandle == NULL || fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if(info->map == NULL){
+        return RC_MAP_FAILED;
+    }
+    if(pageNum >= fHandle->totalNumPages || pageNum < 0){
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    *page = info->map + pageOffset(info, pageNum);
+    return RC_OK;
+}
+
+/**
+ *  read a page and move the current page position to it
+ *
+ *  @param pageNum the page to read
+ *  @param fHandle saves opend txt file's infomation
+ *  @param memPage where page content is saved
+ *
+ *  @return RC_OK indicates reading success
+ */
+static RC readBlockAndSeek (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+    RC status = readBlock(pageNum, fHandle, memPage);
+    if(status == RC_OK){
+        fHandle->curPagePos = pageNum;
+    }
+    return status;
+}
+
 /**
  *  the first page content
  *
@@ -167,7 +710,7 @@ int getBlockPos (SM_FileHandle *fHandle)
  */
 RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
-    return readBlock(0, fHandle, memPage);
+    return readBlockAndSeek(0, fHandle, memPage);
 }
 
 /**
@@ -180,7 +723,7 @@ RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  */
 RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
-    return readBlock(fHandle->curPagePos-1, fHandle, memPage);
+    return readBlockAndSeek(fHandle->curPagePos-1, fHandle, memPage);
 }
 /**
  *  the current page content
@@ -192,7 +735,7 @@ RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  */
 RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
-    return readBlock(fHandle->curPagePos, fHandle, memPage);
+    return readBlockAndSeek(fHandle->curPagePos, fHandle, memPage);
 }
 /**
  *  the next page content
@@ -204,7 +747,7 @@ RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  */
 RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
-    return readBlock(fHandle->curPagePos+1, fHandle, memPage);
+    return readBlockAndSeek(fHandle->curPagePos+1, fHandle, memPage);
 }
 /**
  *  the last page content
@@ -216,9 +759,88 @@ RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  */
 RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
-    return readBlock(fHandle->totalNumPages, fHandle, memPage);
+    return readBlockAndSeek(fHandle->totalNumPages-1, fHandle, memPage);
+}
+
+
+/**
+ *  Read or write count contiguous pages with one vectored call
+ *
+ *  @param startPage The first page
+ *  @param count     The number of pages
+ *  @param fHandle   saves opend file's infomation
+ *  @param buffers   One page buffer per page
+ *  @param isWrite   1 to write, 0 to read
+ *
+ *  @return RC_OK indicates success
+ */
+static RC transferBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle buffers[], int isWrite)
+{
+    struct iovec localIov[64];
+    struct iovec *iov = localIov;
+    SM_FileInfo *info;
+    RC status;
+    int i;
+
+    if(fHandle == NULL || fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if(count < 0 || startPage < 0 || startPage + count > fHandle->totalNumPages){
+        return isWrite ? RC_FILE_NOT_FOUND : RC_READ_NON_EXISTING_PAGE;
+    }
+    info = fHandle->mgmtInfo;
+
+    //a mapped file or unaligned direct I/O buffers go page by page
+    if(info->map != NULL || (info->flags & SM_OPEN_DIRECT)){
+        for(i = 0; i < count; i++){
+            if(info->map == NULL && (uintptr_t)buffers[i] % SM_DIRECT_IO_ALIGN != 0){
+                break;
+            }
+        }
+        if(info->map != NULL || i < count){
+            for(i = 0; i < count; i++){
+                status = isWrite ? writeBlock(startPage + i, fHandle, buffers[i])
+                                 : readBlock(startPage + i, fHandle, buffers[i]);
+                if(status != RC_OK){
+                    return status;
+                }
+            }
+            return RC_OK;
+        }
+    }
+
+    if(count > 64){
+        iov = malloc(count * sizeof(struct iovec));
+        if(iov == NULL){
+            return isWrite ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+        }
+    }
+    for(i = 0; i < count; i++){
+        iov[i].iov_base = buffers[i];
+        iov[i].iov_len = info->pageSize;
+    }
+    status = transferVector(info->fd, iov, count, pageOffset(info, startPage), isWrite);
+    if(iov != localIov){
+        free(iov);
+    }
+    return status;
 }
 
+/**
+ *  Read count contiguous pages starting at startPage with a single vectored read.
+ *  Like readBlock it leaves curPagePos alone.
+ *
+ *  @param startPage The first page to read
+ *  @param count     The number of pages
+ *  @param fHandle   saves opend file's infomation
+ *  @param buffers   buffers[i] receives page startPage + i
+ *
+ *  @return RC_OK indicates reading success
+ */
+RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle buffers[])
+{
+    return transferBlocks(startPage, count, fHandle, buffers, 0);
+}
 
 /*
 *******************  Write Functions  *************************
@@ -226,7 +848,8 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 
 /**
  *  Description:
- *              Write a block in memory to file
+ *              Write a block in memory to file. Like readBlock it writes at a fixed
+ *              position and leaves curPagePos alone.
  *
  *  @param pageNum which page do you want to be written
  *  @param fHandle The structure incloud the info of file
@@ -235,29 +858,45 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  *  @return success or fail
  */
 RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage){
-    
+
+    if(fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
     //make sure pageNum is valid
-    if(pageNum > fHandle->totalNumPages || pageNum < 0){
+    if(pageNum >= fHandle->totalNumPages || pageNum < 0){
         return RC_FILE_NOT_FOUND;
     }
-    //set the file pointer
-    long size = (pageNum)*PAGE_SIZE*sizeof(char);
-    int seekFlg = fseek(fHandle->mgmtInfo, size, SEEK_SET);
-    
-    if (seekFlg == 0) {
-        //make sure 
-        fwrite(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
-        fHandle->curPagePos = pageNum;
-        return RC_OK;
+
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    if(info->map != NULL){
+        char *target = info->map + pageOffset(info, pageNum);
+        //msync needs an address aligned to the system page size
+        size_t align = (size_t)(target - info->map) % (size_t)sysconf(_SC_PAGESIZE);
+
+        memcpy(target, memPage, info->pageSize);
+        if(msync(target - align, info->pageSize + align, MS_ASYNC) != 0){
+            return RC_WRITE_FAILED;
         }
-    
-    else{
-        return RC_CANNT_SET_POINTER;
+        return RC_OK;
     }
-    
+    return writePage(info, pageNum, memPage);
 
 }
 
+/**
+ *  Write count contiguous pages starting at startPage with a single vectored write
+ *
+ *  @param startPage The first page to write
+ *  @param count     The number of pages
+ *  @param fHandle   The structure incloud the info of file
+ *  @param buffers   buffers[i] holds page startPage + i
+ *
+ *  @return success or fail
+ */
+RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle buffers[]){
+    return transferBlocks(startPage, count, fHandle, buffers, 1);
+}
+
 /**
  *  Write current block in memory to a file
  *
@@ -283,34 +922,18 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage){
  *  @return success or fail
  */
 RC appendEmptyBlock (SM_FileHandle *fHandle){
-	
-    int seekFlg;
-    
-    //allocates memory and return a pointer to it
-    char *newPage = calloc(PAGE_SIZE, sizeof(char));
-    //seeks file write pointer to the last page
-    seekFlg = fseek(fHandle->mgmtInfo,(fHandle->totalNumPages)*PAGE_SIZE*sizeof(char) , SEEK_END);
-    
-    if (seekFlg == 0){
-        
-        // writes data from the memory block pointed by newPage to the file
-       size_t writeSize = fwrite(newPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
-        if (writeSize==0)
-        {
-            RC_WRITE_FAILED;
-        }
-        
-        fHandle->totalNumPages = fHandle->totalNumPages + 1;
-        fHandle->curPagePos = fHandle->totalNumPages;
-        rewind(fHandle->mgmtInfo);
 
-        free(newPage);
-        return RC_OK;
-	}
-    else{
-        free(newPage);
-        return RC_WRITE_FAILED;
-	}
+    if(fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    RC status = growFile(fHandle, fHandle->totalNumPages + 1);
+    if (status != RC_OK){
+        return status;
+    }
+
+    fHandle->curPagePos = fHandle->totalNumPages - 1;
+    return RC_OK;
 }
 /**
  *  If the file has less than numberOfPages pages then increase the size to numberOfPages.
@@ -321,19 +944,679 @@ RC appendEmptyBlock (SM_FileHandle *fHandle){
  *  @return success or fail
  */
 RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle){
-    //How many pages we need to add to meet the numberOfPages
-    int pages;
+    if (fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if (fHandle->totalNumPages < numberOfPages){
+        return growFile(fHandle, numberOfPages);
+    }
+    return RC_OK;
+}
+
+/**
+ *  Set the extent growth policy of an open file. When the file has to grow
+ *  beyond its last extent, it grows to
+ *  max(numberOfPages, totalNumPages * (1 + percent / 100), totalNumPages + minPages) pages,
+ *  so a hot append path does not extend the file and rewrite its header one
+ *  page at a time. The pages behind totalNumPages are cut off again when the
+ *  file is closed. 0 and 0 turn extents off, which is the default.
+ *
+ *  @param fHandle  The structure incloud the information of file
+ *  @param percent  Grow by this percentage of the current size, e.g. 12 for 12.5% rounded down
+ *  @param minPages Grow by at least this many pages
+ *
+ *  @return success or fail
+ */
+RC setExtentGrowth (SM_FileHandle *fHandle, int percent, int minPages){
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    info->growthPercent = percent > 0 ? percent : 0;
+    info->growthPages = minPages > 0 ? minPages : 0;
+    return RC_OK;
+}
+
+/*
+*******************  Asynchronous I/O  *************************
+*/
+
+#define SM_ASYNC_READ 0
+#define SM_ASYNC_WRITE 1
+#define SM_ASYNC_MAX_THREADS 8
+
+/**
+ *  One queued page read or write
+ */
+typedef struct SM_AsyncRequest{
+    int op;
+    int pageNum;
+    char *memPage;
+    void *userData;
+    RC status;
+}SM_AsyncRequest;
+
+/**
+ *  The submission/completion engine. Requests are numbered by their slot
+ *  in requests; free slots are kept on a stack and finished requests wait
+ *  in the done ring until they are reaped.
+ */
+struct SM_AsyncIO{
+    SM_FileHandle *fHandle;
+    int queueDepth;
+    int inFlight;
+    SM_AsyncRequest *requests;
+    int *freeSlots;
+    int numFree;
+    int *done;
+    int doneHead;
+    int doneCount;
+    int useUring;
+#ifdef SM_HAVE_URING
+    int ringFd;
+    void *sqRing;
+    void *cqRing;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+    unsigned sqLocalTail;
+    int toSubmit;
+    int ringOpen;       //the ring is set up, also after the threads took over
+    int ringPending;    //requests in the ring which were not drained yet
+#endif
+    pthread_t *threads;
+    int numThreads;
+    int *pending;
+    int pendingHead;
+    int pendingCount;
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t workCond;
+    pthread_cond_t doneCond;
+};
+
+/**
+ *  Run a request synchronously
+ *
+ *  @param aio The engine
+ *  @param req The request
+ */
+static void runRequest(SM_AsyncIO *aio, SM_AsyncRequest *req){
+    if(req->op == SM_ASYNC_READ){
+        req->status = readBlock(req->pageNum, aio->fHandle, req->memPage);
+    }
+    else{
+        req->status = writeBlock(req->pageNum, aio->fHandle, req->memPage);
+    }
+}
+
+/**
+ *  Put a finished request on the done ring. The caller holds the lock in thread mode.
+ *
+ *  @param aio  The engine
+ *  @param slot The slot of the request
+ */
+static void pushDone(SM_AsyncIO *aio, int slot){
+    aio->done[(aio->doneHead + aio->doneCount) % aio->queueDepth] = slot;
+    aio->doneCount++;
+}
+
+/**
+ *  A worker of the thread pool fallback
+ *
+ *  @param arg The engine
+ *
+ *  @return NULL
+ */
+static void *asyncWorker(void *arg){
+    SM_AsyncIO *aio = arg;
+
+    pthread_mutex_lock(&aio->lock);
+    while(1){
+        while(!aio->stopping && aio->pendingCount == 0){
+            pthread_cond_wait(&aio->workCond, &aio->lock);
+        }
+        if(aio->pendingCount == 0){
+            break;
+        }
+        int slot = aio->pending[aio->pendingHead];
+        aio->pendingHead = (aio->pendingHead + 1) % aio->queueDepth;
+        aio->pendingCount--;
+        pthread_mutex_unlock(&aio->lock);
+
+        runRequest(aio, &aio->requests[slot]);
+
+        pthread_mutex_lock(&aio->lock);
+        pushDone(aio, slot);
+        pthread_cond_signal(&aio->doneCond);
+    }
+    pthread_mutex_unlock(&aio->lock);
+    return NULL;
+}
+
+/**
+ *  Hand a request to the thread pool. The caller holds the lock.
+ *
+ *  @param aio  The engine
+ *  @param slot The slot of the request
+ */
+static void queuePending(SM_AsyncIO *aio, int slot){
+    aio->pending[(aio->pendingHead + aio->pendingCount) % aio->queueDepth] = slot;
+    aio->pendingCount++;
+    pthread_cond_signal(&aio->workCond);
+}
+
+/**
+ *  Start the thread pool, for an engine without io_uring or one whose
+ *  kernel turned out not to offer the operations
+ *
+ *  @param aio The engine
+ *
+ *  @return RC_OK, or RC_ASYNC_IO_FAILED if no thread could be started
+ */
+static RC startThreads(SM_AsyncIO *aio){
+    int wanted = aio->queueDepth < SM_ASYNC_MAX_THREADS ? aio->queueDepth : SM_ASYNC_MAX_THREADS;
+
+    aio->threads = malloc(wanted * sizeof(pthread_t));
+    if(aio->threads == NULL){
+        return RC_ASYNC_IO_FAILED;
+    }
+    //only the threads which were created are joined
+    for(aio->numThreads = 0; aio->numThreads < wanted; aio->numThreads++){
+        if(pthread_create(&aio->threads[aio->numThreads], NULL, asyncWorker, aio) != 0){
+            break;
+        }
+    }
+    if(aio->numThreads == 0){
+        free(aio->threads);
+        aio->threads = NULL;
+        return RC_ASYNC_IO_FAILED;
+    }
+    return RC_OK;
+}
+
+#ifdef SM_HAVE_URING
+/**
+ *  Set up an io_uring instance with room for queueDepth requests
+ *
+ *  @param aio The engine
+ *
+ *  @return RC_OK, or RC_ASYNC_IO_FAILED if the kernel does not offer io_uring
+ */
+static RC initUring(SM_AsyncIO *aio){
+    struct io_uring_params p;
+    char *sq, *cq;
+
+    memset(&p, 0, sizeof(p));
+    aio->ringFd = (int)syscall(__NR_io_uring_setup, aio->queueDepth, &p);
+    if(aio->ringFd < 0){
+        return RC_ASYNC_IO_FAILED;
+    }
+
+    aio->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    aio->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP){
+        if(aio->cqRingSize > aio->sqRingSize){
+            aio->sqRingSize = aio->cqRingSize;
+        }
+        aio->cqRingSize = aio->sqRingSize;
+    }
+    aio->sqRing = mmap(NULL, aio->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       aio->ringFd, IORING_OFF_SQ_RING);
+    if(aio->sqRing == MAP_FAILED){
+        close(aio->ringFd);
+        return RC_ASYNC_IO_FAILED;
+    }
+    if(p.features & IORING_FEAT_SINGLE_MMAP){
+        aio->cqRing = aio->sqRing;
+    }
+    else{
+        aio->cqRing = mmap(NULL, aio->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           aio->ringFd, IORING_OFF_CQ_RING);
+        if(aio->cqRing == MAP_FAILED){
+            munmap(aio->sqRing, aio->sqRingSize);
+            close(aio->ringFd);
+            return RC_ASYNC_IO_FAILED;
+        }
+    }
+    aio->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    aio->sqes = mmap(NULL, aio->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     aio->ringFd, IORING_OFF_SQES);
+    if(aio->sqes == MAP_FAILED){
+        if(aio->cqRing != aio->sqRing){
+            munmap(aio->cqRing, aio->cqRingSize);
+        }
+        munmap(aio->sqRing, aio->sqRingSize);
+        close(aio->ringFd);
+        return RC_ASYNC_IO_FAILED;
+    }
+
+    sq = aio->sqRing;
+    cq = aio->cqRing;
+    aio->sqTail = (unsigned *)(sq + p.sq_off.tail);
+    aio->sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+    aio->sqArray = (unsigned *)(sq + p.sq_off.array);
+    aio->cqHead = (unsigned *)(cq + p.cq_off.head);
+    aio->cqTail = (unsigned *)(cq + p.cq_off.tail);
+    aio->cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+    aio->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    aio->sqLocalTail = *aio->sqTail;
+    aio->toSubmit = 0;
+    return RC_OK;
+}
+
+/**
+ *  Release the io_uring instance
+ *
+ *  @param aio The engine
+ */
+static void freeUring(SM_AsyncIO *aio){
+    munmap(aio->sqes, aio->sqesSize);
+    if(aio->cqRing != aio->sqRing){
+        munmap(aio->cqRing, aio->cqRingSize);
+    }
+    munmap(aio->sqRing, aio->sqRingSize);
+    close(aio->ringFd);
+}
+
+/**
+ *  Move the completions the kernel has posted to the done ring. A request
+ *  whose operation the kernel does not offer goes to the thread pool, and
+ *  so do the requests queued after it. The caller holds the lock.
+ *
+ *  @param aio The engine
+ */
+static void drainUring(SM_AsyncIO *aio){
+    SM_FileInfo *info = aio->fHandle->mgmtInfo;
+    unsigned head = *aio->cqHead;
+    unsigned tail = __atomic_load_n(aio->cqTail, __ATOMIC_ACQUIRE);
+
+    while(head != tail){
+        struct io_uring_cqe *cqe = &aio->cqes[head & *aio->cqMask];
+        int slot = (int)cqe->user_data;
+        SM_AsyncRequest *req = &aio->requests[slot];
+
+        head++;
+        aio->ringPending--;
+        if(cqe->res == info->pageSize){
+            req->status = RC_OK;
+        }
+        else if(cqe->res >= 0){
+            //a short transfer, finish the page synchronously
+            runRequest(aio, req);
+        }
+        else if((cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP)
+                && (aio->threads != NULL || startThreads(aio) == RC_OK)){
+            aio->useUring = 0;
+            queuePending(aio, slot);
+            continue;
+        }
+        else{
+            req->status = req->op == SM_ASYNC_READ ? RC_READ_FAIL : RC_WRITE_FAILED;
+        }
+        pushDone(aio, slot);
+    }
+    __atomic_store_n(aio->cqHead, head, __ATOMIC_RELEASE);
+}
+
+/**
+ *  Hand the queued submissions to the kernel and wait for some completions
+ *
+ *  @param aio     The engine
+ *  @param minWait The number of completions to wait for
+ *
+ *  @return RC_OK or RC_ASYNC_IO_FAILED
+ */
+static RC enterUring(SM_AsyncIO *aio, int minWait){
+    unsigned flags = minWait > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    if(aio->toSubmit == 0 && minWait == 0){
+        return RC_OK;
+    }
+    while(1){
+        int ret = (int)syscall(__NR_io_uring_enter, aio->ringFd, aio->toSubmit, minWait, flags, NULL, 0);
+        if(ret >= 0){
+            //entries the kernel did not take yet stay in the ring for the next call
+            aio->toSubmit = ret < aio->toSubmit ? aio->toSubmit - ret : 0;
+            return RC_OK;
+        }
+        if(errno == EINTR || ((errno == EAGAIN || errno == EBUSY) && minWait > 0)){
+            continue;
+        }
+        if(errno == EAGAIN || errno == EBUSY){
+            return RC_OK;
+        }
+        return RC_ASYNC_IO_FAILED;
+    }
+}
+#endif
+
+/**
+ *  Stop the threads of an engine and release it, the outstanding requests
+ *  are dropped. Also unwinds an engine whose initialization failed.
+ *
+ *  @param aio The engine
+ */
+static void freeAsyncIO(SM_AsyncIO *aio){
     int i;
-    int totalNum = fHandle->totalNumPages;
-    // Use appendOfPages to increase the number of pages in file
-	if (totalNum <= numberOfPages)
-        {
 
-		pages = numberOfPages - totalNum + 1;
+    if(aio->threads != NULL){
+        pthread_mutex_lock(&aio->lock);
+        aio->stopping = 1;
+        pthread_cond_broadcast(&aio->workCond);
+        pthread_mutex_unlock(&aio->lock);
+        for(i = 0; i < aio->numThreads; i++){
+            pthread_join(aio->threads[i], NULL);
+        }
+        free(aio->threads);
+    }
+#ifdef SM_HAVE_URING
+    if(aio->ringOpen){
+        freeUring(aio);
+    }
+#endif
+    pthread_mutex_destroy(&aio->lock);
+    pthread_cond_destroy(&aio->workCond);
+    pthread_cond_destroy(&aio->doneCond);
+    free(aio->requests);
+    free(aio->freeSlots);
+    free(aio->done);
+    free(aio->pending);
+    free(aio);
+}
+
+/**
+ *  Create an asynchronous I/O engine for an open file. It uses io_uring
+ *  where the kernel offers it and a pool of threads doing readBlock/writeBlock
+ *  otherwise, or always with SM_ASYNC_THREADS. An io_uring engine moves to
+ *  the threads once the kernel turns out not to offer its operations.
+ *
+ *  @param fHandle    The open file, it must stay open while the engine is used
+ *  @param queueDepth The number of requests which may be outstanding at once
+ *  @param flags      The SM_ASYNC_* flags
+ *  @param aio        Where the engine is saved
+ *
+ *  @return RC_OK, or RC_ASYNC_IO_FAILED if the engine cannot be set up
+ */
+RC initAsyncIO (SM_FileHandle *fHandle, int queueDepth, int flags, SM_AsyncIO **aio){
+    SM_AsyncIO *engine;
+    int i;
+
+    if(fHandle == NULL || fHandle->mgmtInfo == NULL){
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    if(queueDepth <= 0){
+        return RC_ASYNC_IO_FAILED;
+    }
+
+    engine = calloc(1, sizeof(SM_AsyncIO));
+    if(engine == NULL){
+        return RC_ASYNC_IO_FAILED;
+    }
+    engine->fHandle = fHandle;
+    engine->queueDepth = queueDepth;
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->workCond, NULL);
+    pthread_cond_init(&engine->doneCond, NULL);
+    engine->requests = malloc(queueDepth * sizeof(SM_AsyncRequest));
+    engine->freeSlots = malloc(queueDepth * sizeof(int));
+    engine->done = malloc(queueDepth * sizeof(int));
+    engine->pending = malloc(queueDepth * sizeof(int));
+    if(engine->requests == NULL || engine->freeSlots == NULL || engine->done == NULL
+       || engine->pending == NULL){
+        freeAsyncIO(engine);
+        return RC_ASYNC_IO_FAILED;
+    }
+    for(i = 0; i < queueDepth; i++){
+        engine->freeSlots[i] = queueDepth - 1 - i;
+    }
+    engine->numFree = queueDepth;
+
+#ifdef SM_HAVE_URING
+    if(!(flags & SM_ASYNC_THREADS) && initUring(engine) == RC_OK){
+        engine->useUring = 1;
+        engine->ringOpen = 1;
+    }
+#endif
+    if(!engine->useUring && startThreads(engine) != RC_OK){
+        freeAsyncIO(engine);
+        return RC_ASYNC_IO_FAILED;
+    }
+
+    *aio = engine;
+    return RC_OK;
+}
+
+/**
+ *  Queue a request
+ *
+ *  @param aio      The engine
+ *  @param op       SM_ASYNC_READ or SM_ASYNC_WRITE
+ *  @param pageNum  The page
+ *  @param memPage  The page buffer, it must stay valid until the request is reaped
+ *  @param userData Handed back with the completion
+ *
+ *  @return RC_OK, or RC_ASYNC_QUEUE_FULL if queueDepth requests are outstanding
+ */
+static RC queueRequest(SM_AsyncIO *aio, int op, int pageNum, SM_PageHandle memPage, void *userData){
+    SM_FileInfo *info = aio->fHandle->mgmtInfo;
+    SM_AsyncRequest *req;
+    int slot;
+
+    if(pageNum >= aio->fHandle->totalNumPages || pageNum < 0){
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    if(aio->numFree == 0){
+        return RC_ASYNC_QUEUE_FULL;
+    }
+    slot = aio->freeSlots[--aio->numFree];
+    req = &aio->requests[slot];
+    req->op = op;
+    req->pageNum = pageNum;
+    req->memPage = memPage;
+    req->userData = userData;
+    aio->inFlight++;
+
+    //a mapped file is only a memcpy away
+    if(info->map != NULL){
+        runRequest(aio, req);
+        pthread_mutex_lock(&aio->lock);
+        pushDone(aio, slot);
+        pthread_mutex_unlock(&aio->lock);
+        return RC_OK;
+    }
 
-        for (i=0; i < pages; i++){
-			appendEmptyBlock(fHandle);
+#ifdef SM_HAVE_URING
+    if(aio->useUring){
+        //direct I/O needs an aligned buffer, others are done right away
+        if((info->flags & SM_OPEN_DIRECT) && (uintptr_t)memPage % SM_DIRECT_IO_ALIGN != 0){
+            runRequest(aio, req);
+            pthread_mutex_lock(&aio->lock);
+            pushDone(aio, slot);
+            pthread_mutex_unlock(&aio->lock);
+            return RC_OK;
         }
+        unsigned index = aio->sqLocalTail & *aio->sqMask;
+        struct io_uring_sqe *sqe = &aio->sqes[index];
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = op == SM_ASYNC_READ ? IORING_OP_READ : IORING_OP_WRITE;
+        sqe->fd = info->fd;
+        sqe->addr = (unsigned long long)(uintptr_t)memPage;
+        sqe->len = info->pageSize;
+        sqe->off = (unsigned long long)pageOffset(info, pageNum);
+        sqe->user_data = slot;
+        aio->sqArray[index] = index;
+        aio->sqLocalTail++;
+        __atomic_store_n(aio->sqTail, aio->sqLocalTail, __ATOMIC_RELEASE);
+        aio->toSubmit++;
+        aio->ringPending++;
+        return RC_OK;
+    }
+#endif
+
+    pthread_mutex_lock(&aio->lock);
+    queuePending(aio, slot);
+    pthread_mutex_unlock(&aio->lock);
+    return RC_OK;
+}
+
+/**
+ *  Queue an asynchronous page read
+ *
+ *  @param aio      The engine
+ *  @param pageNum  The page to read
+ *  @param memPage  Where the page is saved, it must stay valid until the request is reaped
+ *  @param userData Handed back with the completion
+ *
+ *  @return RC_OK, or RC_ASYNC_QUEUE_FULL if queueDepth requests are outstanding
+ */
+RC submitReadBlock (SM_AsyncIO *aio, int pageNum, SM_PageHandle memPage, void *userData){
+    return queueRequest(aio, SM_ASYNC_READ, pageNum, memPage, userData);
+}
+
+/**
+ *  Queue an asynchronous page write
+ *
+ *  @param aio      The engine
+ *  @param pageNum  The page to write
+ *  @param memPage  The content of the page, it must stay valid until the request is reaped
+ *  @param userData Handed back with the completion
+ *
+ *  @return RC_OK, or RC_ASYNC_QUEUE_FULL if queueDepth requests are outstanding
+ */
+RC submitWriteBlock (SM_AsyncIO *aio, int pageNum, SM_PageHandle memPage, void *userData){
+    return queueRequest(aio, SM_ASYNC_WRITE, pageNum, memPage, userData);
+}
+
+/**
+ *  Start the queued requests without waiting for them
+ *
+ *  @param aio The engine
+ *
+ *  @return RC_OK indicates success
+ */
+RC submitAsyncIO (SM_AsyncIO *aio){
+#ifdef SM_HAVE_URING
+    if(aio->useUring){
+        return enterUring(aio, 0);
+    }
+#endif
+    return RC_OK;
+}
+
+/**
+ *  Start the queued requests and collect finished ones
+ *
+ *  @param aio            The engine
+ *  @param completions    Where the finished requests are saved
+ *  @param maxCompletions The room in completions
+ *  @param minCompletions Wait until at least this many requests are finished (limited by the outstanding ones)
+ *  @param numReaped      Where the number of saved completions is stored
+ *
+ *  @return RC_OK indicates success
+ */
+RC reapCompletions (SM_AsyncIO *aio, SM_Completion *completions, int maxCompletions,
+                    int minCompletions, int *numReaped){
+    int n = 0;
+#ifdef SM_HAVE_URING
+    int entered = 0;
+#endif
+
+    if(minCompletions > maxCompletions){
+        minCompletions = maxCompletions;
+    }
+    if(minCompletions > aio->inFlight){
+        minCompletions = aio->inFlight;
+    }
+
+    pthread_mutex_lock(&aio->lock);
+    while(1){
+#ifdef SM_HAVE_URING
+        if(aio->ringOpen){
+            int wait;
+
+            drainUring(aio);
+            //the kernel is waited for only as long as it holds requests, the threads signal theirs
+            wait = minCompletions - aio->doneCount;
+            wait = wait < aio->ringPending ? wait : aio->ringPending;
+            if(wait > 0 || (aio->toSubmit > 0 && !entered)){
+                RC status;
+
+                pthread_mutex_unlock(&aio->lock);
+                status = enterUring(aio, wait > 0 ? wait : 0);
+                if(status != RC_OK){
+                    return status;
+                }
+                entered = 1;
+                pthread_mutex_lock(&aio->lock);
+                continue;
+            }
+        }
+#endif
+        if(aio->doneCount >= minCompletions){
+            break;
+        }
+        pthread_cond_wait(&aio->doneCond, &aio->lock);
+    }
+
+    while(n < maxCompletions && aio->doneCount > 0){
+        int slot = aio->done[aio->doneHead];
+        SM_AsyncRequest *req = &aio->requests[slot];
+
+        aio->doneHead = (aio->doneHead + 1) % aio->queueDepth;
+        aio->doneCount--;
+        completions[n].pageNum = req->pageNum;
+        completions[n].memPage = req->memPage;
+        completions[n].userData = req->userData;
+        completions[n].status = req->status;
+        aio->freeSlots[aio->numFree++] = slot;
+        aio->inFlight--;
+        n++;
+    }
+
+    pthread_mutex_unlock(&aio->lock);
+    *numReaped = n;
+    return RC_OK;
+}
+
+/**
+ *  The number of requests which were queued and not reaped yet
+ *
+ *  @param aio The engine
+ *
+ *  @return the number of outstanding requests
+ */
+int getAsyncInFlight (SM_AsyncIO *aio){
+    return aio->inFlight;
+}
+
+/**
+ *  Wait for the outstanding requests and release the engine. Their completions are dropped.
+ *
+ *  @param aio The engine
+ *
+ *  @return RC_OK indicates success
+ */
+RC shutdownAsyncIO (SM_AsyncIO *aio){
+    SM_Completion completion;
+    int n;
+
+    while(aio->inFlight > 0){
+        RC status = reapCompletions(aio, &completion, 1, 1, &n);
+        if(status != RC_OK){
+            return status;
         }
+    }
+
+    freeAsyncIO(aio);
     return RC_OK;
 }
@@ -15,29 +15,72 @@ typedef struct SM_FileHandle {
 
 typedef char* SM_PageHandle;
 
+/* flags of openPageFileWithFlags */
+#define SM_OPEN_DEFAULT 0
+#define SM_OPEN_MMAP 1      // map the whole file, pages are copied from and to the mapping
+#define SM_OPEN_DIRECT 2    // bypass the kernel page cache, see SM_DIRECT_IO_ALIGN
+
+/* page sizes of createPageFileWithPageSize, PAGE_SIZE is the default */
+#define SM_MIN_PAGE_SIZE 4096
+#define SM_MAX_PAGE_SIZE 65536
+
+/* page buffers aligned to this many bytes are read and written without a bounce buffer in SM_OPEN_DIRECT mode */
+#define SM_DIRECT_IO_ALIGN 4096
+
+/* asynchronous page I/O */
+typedef struct SM_AsyncIO SM_AsyncIO;
+
+typedef struct SM_Completion {
+  int pageNum;
+  SM_PageHandle memPage;
+  void *userData;
+  RC status;
+} SM_Completion;
+
+/* flags of initAsyncIO */
+#define SM_ASYNC_DEFAULT 0
+#define SM_ASYNC_THREADS 1  // use the thread pool even where io_uring is available
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileWithPageSize (char *fileName, int pageSize);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC openPageFileWithFlags (char *fileName, SM_FileHandle *fHandle, int flags);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern int getBlockPos (SM_FileHandle *fHandle);
+extern int getPageSize (SM_FileHandle *fHandle);
+extern RC getBlockPointer (int pageNum, SM_FileHandle *fHandle, SM_PageHandle *page);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle buffers[]);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int count, SM_FileHandle *fHandle, SM_PageHandle buffers[]);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC setExtentGrowth (SM_FileHandle *fHandle, int percent, int minPages);
+
+/* asynchronous reading and writing */
+extern RC initAsyncIO (SM_FileHandle *fHandle, int queueDepth, int flags, SM_AsyncIO **aio);
+extern RC submitReadBlock (SM_AsyncIO *aio, int pageNum, SM_PageHandle memPage, void *userData);
+extern RC submitWriteBlock (SM_AsyncIO *aio, int pageNum, SM_PageHandle memPage, void *userData);
+extern RC submitAsyncIO (SM_AsyncIO *aio);
+extern RC reapCompletions (SM_AsyncIO *aio, SM_Completion *completions, int maxCompletions,
+                           int minCompletions, int *numReaped);
+extern int getAsyncInFlight (SM_AsyncIO *aio);
+extern RC shutdownAsyncIO (SM_AsyncIO *aio);
 
 #endif
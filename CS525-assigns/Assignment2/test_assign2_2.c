@@ -0,0 +1,1839 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)			        \
+do {									\
+char *real;								\
+char *_exp = (char *) (expected);                                   \
+real = sprintPoolContent(bm);					\
+if (strcmp((_exp),real) != 0)					\
+{									\
+printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);							\
+exit(1);							\
+}									\
+printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+free(real);								\
+} while(0)
+
+// test and helper methods
+static void createDummyPages(BM_BufferPool *bm, int num, BM_PoolOptions *options);
+static void checkDummyPages(BM_BufferPool *bm, int num, BM_PoolOptions *options);
+
+static void testMmapBackend (void);
+static void testDirectBackend (void);
+static void testAsyncIO (void);
+static void testVectoredIO (void);
+static void testFileExtension (void);
+static void testPageSizes (void);
+static void testLargePool (void);
+static void testFrameArena (void);
+static void testCLOCK (void);
+static void testLFU (void);
+static void testLRU_K (void);
+static void testARC (void);
+static void test2Q (void);
+static void testConcurrentPool (void);
+static void testPageLatches (void);
+static void testOptimisticReads (void);
+static void testBackgroundWriter (void);
+static void testPrefetch (void);
+static void testScanRing (void);
+static void testPinPages (void);
+static void testFlushPool (void);
+static void testDirtyList (void);
+static void testPageHandles (void);
+
+// main method
+int
+main (void)
+{
+    initStorageManager();
+    testName = "";
+    testMmapBackend();
+    testDirectBackend();
+    testAsyncIO();
+    testVectoredIO();
+    testFileExtension();
+    testPageSizes();
+    testLargePool();
+    testFrameArena();
+    testCLOCK();
+    testLFU();
+    testLRU_K();
+    testARC();
+    test2Q();
+    testConcurrentPool();
+    testPageLatches();
+    testOptimisticReads();
+    testBackgroundWriter();
+    testPrefetch();
+    testScanRing();
+    testPinPages();
+    testFlushPool();
+    testDirtyList();
+    testPageHandles();
+}
+
+// create n pages with content "Page X" through a pool opened with the given options
+void
+createDummyPages(BM_BufferPool *bm, int num, BM_PoolOptions *options)
+{
+    int i;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, options));
+    for (i = 0; i < num; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm,h));
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    free(h);
+}
+
+// read n pages back through a pool opened with the given options and check their content
+void
+checkDummyPages(BM_BufferPool *bm, int num, BM_PoolOptions *options)
+{
+    int i;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char *expected = malloc(sizeof(char) * 512);
+
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, options));
+    for (i = 0; i < num; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", h->pageNum);
+        if (strcmp(expected, h->data) != 0)
+            ASSERT_EQUALS_STRING(expected, h->data, "reading back dummy page content");
+        CHECK(unpinPage(bm,h));
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    free(expected);
+    free(h);
+}
+
+// pages written through one storage backend can be read through the other one
+void
+testMmapBackend (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions mmapOptions;
+    SM_FileHandle fh;
+    SM_PageHandle page;
+    testName = "Reading and writing pages through the mmap backend";
+
+    memset(&mmapOptions, 0, sizeof(mmapOptions));
+    mmapOptions.openFlags = SM_OPEN_MMAP;
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 500, &mmapOptions);
+    checkDummyPages(bm, 500, NULL);
+    checkDummyPages(bm, 500, &mmapOptions);
+
+    createDummyPages(bm, 1000, NULL);
+    checkDummyPages(bm, 1000, &mmapOptions);
+
+    // zero-copy access to the mapping
+    CHECK(openPageFileWithFlags("testbuffer.bin", &fh, SM_OPEN_MMAP));
+    ASSERT_EQUALS_INT(1000, fh.totalNumPages, "all pages are mapped");
+    CHECK(getBlockPointer(42, &fh, &page));
+    ASSERT_EQUALS_STRING("Page-42", page, "pointer into the mapping");
+    ASSERT_ERROR(getBlockPointer(1000, &fh, &page), "no pointer beyond the last page");
+    CHECK(ensureCapacity(2000, &fh));
+    CHECK(getBlockPointer(1999, &fh, &page));
+    ASSERT_EQUALS_STRING("", page, "grown mapping is zero filled");
+    CHECK(closePageFile(&fh));
+
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(2000, fh.totalNumPages, "mapping growth reached the file");
+    ASSERT_ERROR(getBlockPointer(42, &fh, &page), "no pointer without a mapping");
+    CHECK(closePageFile(&fh));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    TEST_DONE();
+}
+
+// pages go through the direct I/O backend into page aligned frames
+void
+testDirectBackend (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions directOptions;
+    SM_FileHandle fh;
+    char *unaligned = malloc(PAGE_SIZE + 1);
+    RC rc;
+    testName = "Reading and writing pages through the direct I/O backend";
+
+    memset(&directOptions, 0, sizeof(directOptions));
+    directOptions.openFlags = SM_OPEN_DIRECT;
+
+    CHECK(createPageFile("testbuffer.bin"));
+    rc = openPageFileWithFlags("testbuffer.bin", &fh, SM_OPEN_DIRECT);
+    if (rc == RC_DIRECT_IO_FAILED)
+    {
+        printf("direct I/O is not supported here, skipping\n");
+        CHECK(destroyPageFile("testbuffer.bin"));
+        free(unaligned);
+        free(bm);
+        free(h);
+        return;
+    }
+    CHECK(rc);
+
+    // an unaligned buffer still works through the bounce buffer
+    CHECK(ensureCapacity(10, &fh));
+    strcpy(unaligned + 1, "unaligned");
+    CHECK(writeBlock(7, &fh, unaligned + 1));
+    memset(unaligned, 0, PAGE_SIZE + 1);
+    CHECK(readBlock(7, &fh, unaligned + 1));
+    ASSERT_EQUALS_STRING("unaligned", unaligned + 1, "unaligned buffer read back");
+    CHECK(closePageFile(&fh));
+
+    createDummyPages(bm, 300, &directOptions);
+    checkDummyPages(bm, 300, NULL);
+    checkDummyPages(bm, 300, &directOptions);
+
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &directOptions));
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_TRUE(((size_t) h->data) % SM_DIRECT_IO_ALIGN == 0, "frame buffers are aligned");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(unaligned);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// write pages through the asynchronous engine and read them back, on io_uring and on the thread pool
+void
+testAsyncIO (void)
+{
+    const int engines[] = {SM_ASYNC_DEFAULT, SM_ASYNC_THREADS};
+    const int numPages = 64;
+    const int queueDepth = 8;
+    SM_FileHandle fh;
+    SM_AsyncIO *aio;
+    SM_Completion completions[8];
+    char *pages = malloc(numPages * PAGE_SIZE);
+    char expected[64];
+    int e, i, n, submitted, reaped;
+    testName = "Asynchronous page reads and writes";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    CHECK(ensureCapacity(numPages, &fh));
+
+    for (e = 0; e < 2; e++)
+    {
+        CHECK(initAsyncIO(&fh, queueDepth, engines[e], &aio));
+
+        // write all pages, never more than queueDepth at once
+        for (i = 0; i < numPages; i++)
+            sprintf(pages + i * PAGE_SIZE, "Page-%i-%i", i, e);
+        submitted = reaped = 0;
+        while (reaped < numPages)
+        {
+            while (submitted < numPages && getAsyncInFlight(aio) < queueDepth)
+            {
+                CHECK(submitWriteBlock(aio, submitted, pages + submitted * PAGE_SIZE, NULL));
+                submitted++;
+            }
+            CHECK(reapCompletions(aio, completions, 8, 1, &n));
+            for (i = 0; i < n; i++)
+                CHECK(completions[i].status);
+            reaped += n;
+        }
+
+        // read them back in reverse order and find the page through userData
+        memset(pages, 0, numPages * PAGE_SIZE);
+        for (i = 0; i < queueDepth; i++)
+            CHECK(submitReadBlock(aio, numPages - 1 - i, pages + (numPages - 1 - i) * PAGE_SIZE,
+                                  pages + (numPages - 1 - i) * PAGE_SIZE));
+        ASSERT_ERROR(submitReadBlock(aio, 0, pages, NULL), "queue depth is respected");
+        ASSERT_ERROR(submitReadBlock(aio, numPages, pages, NULL), "no read beyond the last page");
+        CHECK(reapCompletions(aio, completions, 8, 8, &n));
+        ASSERT_EQUALS_INT(8, n, "all reads completed");
+        for (i = 0; i < n; i++)
+        {
+            CHECK(completions[i].status);
+            ASSERT_TRUE(completions[i].userData == completions[i].memPage, "userData is handed back");
+            sprintf(expected, "Page-%i-%i", completions[i].pageNum, e);
+            ASSERT_EQUALS_STRING(expected, completions[i].memPage, "page read asynchronously");
+        }
+
+        CHECK(shutdownAsyncIO(aio));
+    }
+
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(pages);
+    TEST_DONE();
+}
+
+// runs of pages written with writeBlocks can be read back with readBlock and readBlocks on every backend
+void
+testVectoredIO (void)
+{
+    const int backends[] = {SM_OPEN_DEFAULT, SM_OPEN_MMAP, SM_OPEN_DIRECT};
+    const int numPages = 100;
+    SM_FileHandle fh;
+    SM_PageHandle buffers[100];
+    void *pages;
+    char *single = malloc(PAGE_SIZE);
+    char expected[64];
+    int b, i;
+    RC rc;
+    testName = "Vectored reads and writes of page runs";
+
+    if (posix_memalign(&pages, SM_DIRECT_IO_ALIGN, numPages * PAGE_SIZE) != 0)
+        exit(1);
+    for (i = 0; i < numPages; i++)
+        buffers[i] = (char *) pages + i * PAGE_SIZE;
+
+    CHECK(createPageFile("testbuffer.bin"));
+    for (b = 0; b < 3; b++)
+    {
+        rc = openPageFileWithFlags("testbuffer.bin", &fh, backends[b]);
+        if (rc == RC_DIRECT_IO_FAILED)
+            continue;
+        CHECK(rc);
+        CHECK(ensureCapacity(numPages + 10, &fh));
+
+        for (i = 0; i < numPages; i++)
+            sprintf(buffers[i], "Page-%i-%i", i, b);
+        CHECK(writeBlocks(5, numPages, &fh, buffers));
+        ASSERT_ERROR(writeBlocks(11, numPages, &fh, buffers), "no write beyond the last page");
+
+        CHECK(readBlock(5 + 77, &fh, single));
+        sprintf(expected, "Page-%i-%i", 77, b);
+        ASSERT_EQUALS_STRING(expected, single, "page of a vectored write");
+
+        memset(pages, 0, numPages * PAGE_SIZE);
+        CHECK(readBlocks(5, numPages, &fh, buffers));
+        for (i = 0; i < numPages; i++)
+        {
+            sprintf(expected, "Page-%i-%i", i, b);
+            if (strcmp(expected, buffers[i]) != 0)
+                ASSERT_EQUALS_STRING(expected, buffers[i], "page of a vectored read");
+        }
+        ASSERT_EQUALS_STRING(expected, buffers[numPages - 1], "last page of a vectored read");
+        ASSERT_ERROR(readBlocks(11, numPages, &fh, buffers), "no read beyond the last page");
+
+        CHECK(closePageFile(&fh));
+    }
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(single);
+    free(pages);
+    TEST_DONE();
+}
+
+// growing a file is a size change, with an extent policy it grows by whole extents cut back on close
+void
+testFileExtension (void)
+{
+    const int bigPages = 1 << 20;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions growOptions;
+    SM_FileHandle fh;
+    char *page = malloc(PAGE_SIZE);
+    struct stat st;
+    int i;
+    testName = "Extending page files";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+
+    // a 4GB file is a single size change
+    CHECK(ensureCapacity(bigPages, &fh));
+    ASSERT_EQUALS_INT(bigPages, fh.totalNumPages, "the file grew at once");
+    memset(page, 'x', PAGE_SIZE);
+    CHECK(readLastBlock(&fh, page));
+    ASSERT_TRUE(page[0] == 0 && page[PAGE_SIZE - 1] == 0, "new pages read as zeros");
+    CHECK(ensureCapacity(10, &fh));
+    ASSERT_EQUALS_INT(bigPages, fh.totalNumPages, "ensureCapacity never shrinks");
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    // appends with an extent policy grow the file by 64 pages, then by 64 more
+    // since 12% of 65 pages is less; the header page comes on top
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    CHECK(setExtentGrowth(&fh, 12, 64));
+    for (i = 0; i < 100; i++)
+        CHECK(appendEmptyBlock(&fh));
+    ASSERT_EQUALS_INT(101, fh.totalNumPages, "every append adds one page");
+    ASSERT_EQUALS_INT(100, fh.curPagePos, "append moves to the new page");
+    ASSERT_TRUE(stat("testbuffer.bin", &st) == 0 && st.st_size == (129 + 1) * PAGE_SIZE, "the file grows by whole extents");
+    CHECK(closePageFile(&fh));
+    ASSERT_TRUE(stat("testbuffer.bin", &st) == 0 && st.st_size == (101 + 1) * PAGE_SIZE, "closing cuts the file back to its last page");
+
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(101, fh.totalNumPages, "page count after reopening");
+    CHECK(closePageFile(&fh));
+
+    // a pool with an extent policy still sees every page it wrote
+    memset(&growOptions, 0, sizeof(growOptions));
+    growOptions.growthPages = 256;
+    createDummyPages(bm, 500, &growOptions);
+    checkDummyPages(bm, 500, NULL);
+    ASSERT_TRUE(stat("testbuffer.bin", &st) == 0 && st.st_size == (500 + 1) * PAGE_SIZE, "pool growth keeps the size exact");
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(page);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// page files of 4KB to 64KB pages keep their page size in the header page
+void
+testPageSizes (void)
+{
+    const int backends[] = {SM_OPEN_DEFAULT, SM_OPEN_MMAP, SM_OPEN_DIRECT};
+    const int pageSizes[] = {4096, 16384, 65536};
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    SM_FileHandle fh;
+    char expected[64];
+    FILE *file;
+    int b, p, i, pageSize;
+    RC rc;
+    testName = "Page files with different page sizes";
+
+    ASSERT_ERROR(createPageFileWithPageSize("testbuffer.bin", 2048), "pages smaller than 4KB");
+    ASSERT_ERROR(createPageFileWithPageSize("testbuffer.bin", 131072), "pages larger than 64KB");
+    ASSERT_ERROR(createPageFileWithPageSize("testbuffer.bin", 12288), "page size is a power of two");
+
+    for (p = 0; p < 3; p++)
+        for (b = 0; b < 3; b++)
+        {
+            pageSize = pageSizes[p];
+            CHECK(createPageFileWithPageSize("testbuffer.bin", pageSize));
+            rc = openPageFileWithFlags("testbuffer.bin", &fh, backends[b]);
+            if (rc == RC_DIRECT_IO_FAILED)
+            {
+                CHECK(destroyPageFile("testbuffer.bin"));
+                continue;
+            }
+            CHECK(rc);
+            ASSERT_EQUALS_INT(pageSize, getPageSize(&fh), "page size from the header");
+            ASSERT_EQUALS_INT(1, fh.totalNumPages, "a new file has one page");
+            CHECK(closePageFile(&fh));
+
+            // fill the first and the last byte of every page through a pool
+            memset(&options, 0, sizeof(options));
+            options.openFlags = backends[b];
+            CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+            ASSERT_EQUALS_INT(pageSize, getPoolPageSize(bm), "frames have the page size of the file");
+            for (i = 0; i < 50; i++)
+            {
+                CHECK(pinPage(bm, h, i));
+                sprintf(h->data, "Page-%i", i);
+                h->data[pageSize - 1] = (char) ('a' + i % 26);
+                CHECK(markDirty(bm, h));
+                CHECK(unpinPage(bm, h));
+            }
+            CHECK(shutdownBufferPool(bm));
+
+            CHECK(openPageFile("testbuffer.bin", &fh));
+            ASSERT_EQUALS_INT(50, fh.totalNumPages, "page count from the header");
+            CHECK(closePageFile(&fh));
+
+            CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_FIFO, NULL, &options));
+            for (i = 49; i >= 0; i--)
+            {
+                CHECK(pinPage(bm, h, i));
+                sprintf(expected, "Page-%i", i);
+                if (strcmp(expected, h->data) != 0 || h->data[pageSize - 1] != (char) ('a' + i % 26))
+                    ASSERT_EQUALS_STRING(expected, h->data, "reading back a large page");
+                CHECK(unpinPage(bm, h));
+            }
+            CHECK(shutdownBufferPool(bm));
+            CHECK(destroyPageFile("testbuffer.bin"));
+        }
+
+    // a file without a header is not a page file
+    file = fopen("testbuffer.bin", "w");
+    for (i = 0; i < PAGE_SIZE * 2; i++)
+        fputc('x', file);
+    fclose(file);
+    ASSERT_EQUALS_INT(RC_INVALID_FILE_HEADER, openPageFile("testbuffer.bin", &fh), "no header, no page file");
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a pool of a million frames over a file of two million pages (8GB, sparse)
+void
+testLargePool (void)
+{
+    const int numFrames = 1000000;
+    const int filePages = 2000000;
+    const int numPins = 30000;
+    const int stride = filePages / numPins;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    PageNumber *frameContents;
+    int *fixCounts;
+    char *page = malloc(PAGE_SIZE);
+    char expected[64];
+    int i;
+    testName = "Pool with a million frames over a multi-GB file";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    CHECK(ensureCapacity(filePages, &fh));
+    CHECK(closePageFile(&fh));
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", numFrames, RS_LRU, NULL));
+    for (i = 0; i < numPins; i++)
+    {
+        CHECK(pinPage(bm, h, i * stride + 7));
+        if (i % 100 == 0)
+        {
+            sprintf(h->data, "Page-%i", h->pageNum);
+            CHECK(markDirty(bm, h));
+        }
+    }
+
+    // frames are filled in order and all of them are still pinned
+    frameContents = getFrameContents(bm);
+    fixCounts = getFixCounts(bm);
+    ASSERT_EQUALS_INT(7, frameContents[0], "first frame");
+    ASSERT_EQUALS_INT((numPins - 1) * stride + 7, frameContents[numPins - 1], "last used frame");
+    ASSERT_EQUALS_INT(NO_PAGE, frameContents[numPins], "first free frame");
+    ASSERT_EQUALS_INT(NO_PAGE, frameContents[numFrames - 1], "last frame");
+    ASSERT_EQUALS_INT(1, fixCounts[numPins - 1], "pinned once");
+    ASSERT_TRUE(getDirtyFlags(bm)[100], "dirty frame");
+    ASSERT_EQUALS_INT(numPins, getNumReadIO(bm), "one read per page");
+
+    // a second pin of every page is a hit
+    for (i = 0; i < numPins; i++)
+    {
+        CHECK(pinPage(bm, h, i * stride + 7));
+        CHECK(unpinPage(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(numPins, getNumReadIO(bm), "no read for a page in the pool");
+    ASSERT_EQUALS_INT(0, getFixCounts(bm)[numPins - 1], "all pages unpinned");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(filePages, fh.totalNumPages, "file size is unchanged");
+    CHECK(readBlock((numPins - 100) * stride + 7, &fh, page));
+    sprintf(expected, "Page-%i", (numPins - 100) * stride + 7);
+    ASSERT_EQUALS_STRING(expected, page, "dirty page written on shutdown");
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(page);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// the frames of a pool are consecutive page buffers of one arena, with and without huge pages and mlock
+void
+testFrameArena (void)
+{
+    const int memoryFlags[] = {BM_MEM_DEFAULT, BM_MEM_HUGEPAGES, BM_MEM_LOCK, BM_MEM_HUGEPAGES | BM_MEM_LOCK};
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    char *first;
+    int m, i;
+    RC rc;
+    testName = "Frames in one arena";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    for (m = 0; m < 4; m++)
+    {
+        memset(&options, 0, sizeof(options));
+        options.memoryFlags = memoryFlags[m];
+        rc = initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_FIFO, NULL, &options);
+        if (rc == RC_MEMORY_LOCK_FAILED)
+        {
+            printf("mlock is not allowed here, skipping\n");
+            continue;
+        }
+        CHECK(rc);
+
+        CHECK(pinPage(bm, h, 0));
+        first = h->data;
+        ASSERT_TRUE(((size_t) first) % SM_DIRECT_IO_ALIGN == 0, "arena is aligned");
+        CHECK(unpinPage(bm, h));
+        for (i = 1; i < 10; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            if (h->data != first + i * PAGE_SIZE)
+                ASSERT_TRUE(h->data == first + i * PAGE_SIZE, "frame i follows frame i - 1");
+            sprintf(h->data, "%s-%i", "Page", h->pageNum);
+            CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+        ASSERT_TRUE(h->data == first + 9 * PAGE_SIZE, "frames are consecutive");
+        sprintf(first, "%s-%i", "Page", 0);
+        CHECK(pinPage(bm, h, 0));
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+        CHECK(shutdownBufferPool(bm));
+
+        checkDummyPages(bm, 10, NULL);
+    }
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the CLOCK page replacement strategy
+void
+testCLOCK (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[3x0],[-1 0],[-1 0],[-1 0]",
+        "[3x0],[2 0],[-1 0],[-1 0]",
+        "[3x0],[2 0],[0 0],[-1 0]",
+        "[3x0],[2 0],[0 0],[8 0]",
+        "[4 0],[2 0],[0 0],[8 0]",
+        "[4 0],[2 0],[0 0],[8 0]",
+        "[4 0],[2 0],[5 0],[8 0]",
+        "[4 0],[2 0],[5 0],[0 0]",
+        "[9 0],[2 0],[5 0],[0 0]",
+        "[9 0],[8 0],[5 0],[0 0]",
+        "[9 0],[8 0],[3 0],[0 0]",
+        "[9 0],[8 0],[3 0],[2 0]",
+        // second chance for 9 and 8, 3 stays pinned
+        "[9 0],[8 0],[3 1],[7 0]"
+    };
+    const int requests[] = {3,2,0,8,4,2,5,0,9,8,3,2};
+    const int numRequests = 12;
+    const int pinned[] = {9,8,7,3};
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing CLOCK page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+
+    createDummyPages(bm, 100, NULL);
+
+    ASSERT_ERROR(initBufferPool(bm, "testbuffer.bin", 0, RS_CLOCK, NULL), "a pool needs a frame");
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_CLOCK, NULL));
+
+    // a hit only sets the reference bit of the frame
+    for (i = 0; i < numRequests; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        if (i == 0)
+            CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+
+    CHECK(pinPage(bm, h, 9));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 8));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 3));
+    CHECK(pinPage(bm, h, 7));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL(poolContents[numRequests], bm, "referenced and pinned frames are passed over");
+
+    // nothing to evict when every frame is pinned
+    CHECK(pinPage(bm, h, 9));
+    CHECK(pinPage(bm, h, 8));
+    CHECK(pinPage(bm, h, 7));
+    ASSERT_ERROR(pinPage(bm, h, 1), "all frames are pinned");
+    for (i = 0; i < 4; i++)
+    {
+        h->pageNum = pinned[i];
+        CHECK(unpinPage(bm, h));
+    }
+
+    // check number of write IOs
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(12, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the LFU page replacement strategy, with and without aging
+void
+testLFU (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[1 0],[-1 0],[-1 0]",
+        "[1 0],[-1 0],[-1 0]",
+        "[1 0],[-1 0],[-1 0]",
+        "[1 0],[2 0],[-1 0]",
+        "[1 0],[2 0],[-1 0]",
+        "[1 0],[2 0],[3 0]",
+        "[1 0],[2 0],[4 0]",
+        "[1 0],[2 0],[4 0]",
+        "[1 0],[5 0],[4 0]",
+        "[1 0],[6 0],[4 0]",
+        // 6 is pinned, 4 is the older page with two references
+        "[1 0],[6 1],[7 1]"
+    };
+    const int requests[] = {1,1,1,2,2,3,4,4,5,6};
+    const int numRequests = 10;
+    const int agingRequests[] = {1,1,1,2,3};
+    int agingPeriod = 4;
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LFU page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+
+    createDummyPages(bm, 100, NULL);
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LFU, NULL));
+    for (i = 0; i < numRequests; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+    CHECK(pinPage(bm, h, 6));
+    CHECK(pinPage(bm, h, 7));
+    ASSERT_EQUALS_POOL(poolContents[numRequests], bm, "pinned frames are not evicted");
+    CHECK(unpinPage(bm, h));
+    h->pageNum = 6;
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+    CHECK(shutdownBufferPool(bm));
+
+    // without aging page 1 keeps its three references
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, NULL));
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, agingRequests[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[1 0],[3 0]", bm, "heavy hitter stays");
+    CHECK(shutdownBufferPool(bm));
+
+    // with aging every 4 references its count is halved before page 2 comes in
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, &agingPeriod));
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, agingRequests[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[3 0],[2 0]", bm, "old heavy hitter decays");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the LRU-K page replacement strategy with K = 2 and the retained history of evicted pages
+void
+testLRU_K (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[1 0],[-1 0],[-1 0]",
+        "[1 0],[2 0],[-1 0]",
+        "[1 0],[2 0],[3 0]",
+        "[1 0],[2 0],[3 0]",
+        "[1 0],[2 0],[3 0]",
+        // pages seen once are evicted before 1 and 2, which were seen twice
+        "[1 0],[2 0],[4 0]",
+        "[1 0],[2 0],[5 0]",
+        // 3 comes back with its retained first reference
+        "[1 0],[2 0],[3 0]",
+        "[6 0],[2 0],[3 0]",
+        "[7 0],[2 0],[3 0]"
+    };
+    const int requests[] = {1,2,3,1,2,4,5,3,6,7};
+    const int numRequests = 10;
+    int k = 2;
+    int one = 1;
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LRU-K page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+
+    createDummyPages(bm, 100, NULL);
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &k));
+    for (i = 0; i < numRequests; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+    ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+
+    CHECK(shutdownBufferPool(bm));
+
+    // a pinned page is never the victim, even with the oldest references
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, &k));
+    CHECK(pinPage(bm, h, 1));
+    for (i = 0; i < 2; i++)
+    {
+        CHECK(pinPage(bm, h, 2));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, h, 3));
+    ASSERT_EQUALS_POOL("[1 1],[3 1]", bm, "pinned frames are passed over");
+    CHECK(unpinPage(bm, h));
+    h->pageNum = 1;
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    // K = 1 is LRU
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &one));
+    for (i = 0; i < 7; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[5 0],[2 0],[4 0]", bm, "LRU-1 evicts the least recently used page");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the ARC strategy
+void
+testARC (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[1 0],[-1 0],[-1 0]",
+        "[1 0],[2 0],[-1 0]",
+        "[1 0],[2 0],[-1 0]",
+        "[1 0],[2 0],[-1 0]",
+        "[1 0],[2 0],[3 0]",
+        "[1 0],[2 0],[4 0]",
+        "[1 0],[2 0],[5 0]",
+        "[1 0],[2 0],[6 0]",
+        "[1 0],[2 0],[6 0]",
+        "[1 0],[2 0],[6 0]",
+        "[1 0],[2 0],[7 0]",
+        "[1 0],[2 0],[3 0]",
+        "[1 0],[2 0],[8 0]",
+        "[3 0],[2 0],[8 0]",
+        "[3 0],[9 0],[8 0]"
+    };
+    const int requests[] = {1,2,1,2,3,4,5,6,1,2,7,3,8,3,9};
+    const int numRequests = 15;
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing ARC page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+
+    createDummyPages(bm, 100, NULL);
+
+    // 1 and 2 are referenced twice and survive the scan over 3, 4, 5 and 6;
+    // 3 comes back while it is a ghost and is kept as a frequent page
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ARC, NULL));
+    for (i = 0; i < numRequests; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+    ASSERT_EQUALS_INT(11, getNumReadIO(bm), "check number of read I/Os");
+    CHECK(shutdownBufferPool(bm));
+
+    // a pinned page is never the victim
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_ARC, NULL));
+    CHECK(pinPage(bm, h, 1));
+    CHECK(pinPage(bm, h, 2));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 3));
+    ASSERT_EQUALS_POOL("[1 1],[3 1]", bm, "pinned frames are passed over");
+    CHECK(unpinPage(bm, h));
+    h->pageNum = 1;
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the 2Q strategy
+void
+test2Q (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[1 0],[-1 0],[-1 0],[-1 0]",
+        "[1 0],[2 0],[-1 0],[-1 0]",
+        "[1 0],[2 0],[3 0],[-1 0]",
+        "[1 0],[2 0],[3 0],[4 0]",
+        "[5 0],[2 0],[3 0],[4 0]",
+        "[5 0],[1 0],[3 0],[4 0]",
+        "[5 0],[1 0],[2 0],[4 0]",
+        "[5 0],[1 0],[2 0],[6 0]",
+        "[7 0],[1 0],[2 0],[6 0]",
+        "[7 0],[1 0],[2 0],[8 0]",
+        "[7 0],[1 0],[2 0],[8 0]",
+        "[9 0],[1 0],[2 0],[8 0]",
+        "[9 0],[1 0],[2 0],[8 0]"
+    };
+    const int requests[] = {1,2,3,4,5,1,2,6,7,8,2,9,1};
+    const int numRequests = 13;
+
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing 2Q page replacement";
+
+    CHECK(createPageFile("testbuffer.bin"));
+
+    createDummyPages(bm, 100, NULL);
+
+    // with 4 frames A1in holds one page and A1out two: 1 and 2 come back
+    // from A1out into Am, where the pages of the following scan cannot reach them
+    CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_2Q, NULL));
+    for (i = 0; i < numRequests; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+    }
+    ASSERT_EQUALS_INT(11, getNumReadIO(bm), "check number of read I/Os");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// the work of a thread of testConcurrentPool
+typedef struct ConcurrentWork {
+    BM_BufferPool *bm;
+    unsigned int seed;
+    int numPages;
+    int numOps;
+} ConcurrentWork;
+
+// pin random pages, check their content and mark some of them dirty so they are written back
+static void *
+pinRandomPages (void *arg)
+{
+    ConcurrentWork *work = (ConcurrentWork *) arg;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char expected[64];
+    int i;
+
+    for (i = 0; i < work->numOps; i++)
+    {
+        int pageNum = rand_r(&work->seed) % work->numPages;
+
+        CHECK(pinPage(work->bm, h, pageNum));
+        sprintf(expected, "%s-%i", "Page", pageNum);
+        if (strcmp(expected, h->data) != 0)
+            ASSERT_EQUALS_STRING(expected, h->data, "page content seen by a thread");
+        if (i % 4 == 0)
+            CHECK(markDirty(work->bm, h));
+        CHECK(unpinPage(work->bm, h));
+    }
+    free(h);
+    return NULL;
+}
+
+// threads pin pages of a concurrent pool at once, with misses and write-backs
+void
+testConcurrentPool (void)
+{
+    const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+    const int numStrategies = 7;
+    const int numThreads = 4;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PoolOptions options;
+    pthread_t threads[4];
+    ConcurrentWork work[4];
+    int s, i;
+    testName = "Testing a pool used by several threads";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 200, NULL);
+
+    memset(&options, 0, sizeof(options));
+    options.latchPartitions = 8;
+    for (s = 0; s < numStrategies; s++)
+    {
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 20, strategies[s], NULL, &options));
+        for (i = 0; i < numThreads; i++)
+        {
+            work[i].bm = bm;
+            work[i].seed = i + 1;
+            work[i].numPages = 200;
+            work[i].numOps = 5000;
+            ASSERT_TRUE(pthread_create(&threads[i], NULL, pinRandomPages, &work[i]) == 0, "start a thread");
+        }
+        for (i = 0; i < numThreads; i++)
+            pthread_join(threads[i], NULL);
+
+        for (i = 0; i < 20; i++)
+            ASSERT_EQUALS_INT(0, getFixCounts(bm)[i], "every pin was matched by an unpin");
+        ASSERT_TRUE(getNumReadIO(bm) >= 20, "the threads caused misses");
+        CHECK(shutdownBufferPool(bm));
+        checkDummyPages(bm, 200, NULL);
+    }
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    TEST_DONE();
+}
+
+// the work of a thread of testPageLatches
+typedef struct LatchWork {
+    BM_BufferPool *bm;
+    bool writer;
+    int numOps;
+} LatchWork;
+
+// writers bump two counters of page 0 under an exclusive latch, readers
+// check under a shared latch that they never see one bumped without the other
+static void *
+useLatchedPage (void *arg)
+{
+    LatchWork *work = (LatchWork *) arg;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int counters[2];
+    int i;
+
+    for (i = 0; i < work->numOps; i++)
+    {
+        CHECK(pinPageWithMode(work->bm, h, 0, work->writer ? PIN_EXCLUSIVE : PIN_SHARED));
+        memcpy(counters, h->data + 64, sizeof(counters));
+        if (work->writer)
+        {
+            counters[0]++;
+            memcpy(h->data + 64, counters, sizeof(int));
+            // let the readers run while the page is half updated
+            sched_yield();
+            counters[1]++;
+            memcpy(h->data + 64 + sizeof(int), &counters[1], sizeof(int));
+            CHECK(markDirty(work->bm, h));
+        }
+        else if (counters[0] != counters[1])
+            ASSERT_EQUALS_INT(counters[0], counters[1], "a reader never sees a half updated page");
+        CHECK(unpinPageWithMode(work->bm, h, work->writer ? PIN_EXCLUSIVE : PIN_SHARED));
+    }
+    free(h);
+    return NULL;
+}
+
+// shared and exclusive latches of pinned pages
+void
+testPageLatches (void)
+{
+    const int numThreads = 4;
+    const int numOps = 2000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *other = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    pthread_t threads[4];
+    LatchWork work[4];
+    int counters[2] = {0, 0};
+    int i;
+    testName = "Testing shared and exclusive page latches";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10, NULL);
+
+    memset(&options, 0, sizeof(options));
+    options.latchPartitions = 4;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+
+    // readers share a page
+    CHECK(pinPageWithMode(bm, h, 1, PIN_SHARED));
+    CHECK(pinPageWithMode(bm, other, 1, PIN_SHARED));
+    ASSERT_EQUALS_POOL("[1 2],[-1 0],[-1 0]", bm, "two readers pin the page");
+    ASSERT_EQUALS_INT(RC_PAGE_NOT_LATCHED, unlatchPage(bm, h, PIN_EXCLUSIVE), "the page is not latched exclusively");
+    CHECK(unpinPageWithMode(bm, h, PIN_SHARED));
+    CHECK(unpinPageWithMode(bm, other, PIN_SHARED));
+    ASSERT_EQUALS_INT(RC_NON_EXISTING_PAGE_IN_FRAME, latchPage(bm, h, PIN_SHARED), "only pinned pages can be latched");
+
+    // a writer has it alone, and may downgrade by latching shared after unlatching
+    CHECK(pinPageWithMode(bm, h, 1, PIN_EXCLUSIVE));
+    ASSERT_EQUALS_INT(RC_PAGE_NOT_LATCHED, unlatchPage(bm, h, PIN_SHARED), "the page is not latched shared");
+    CHECK(unlatchPage(bm, h, PIN_EXCLUSIVE));
+    CHECK(latchPage(bm, h, PIN_SHARED));
+    CHECK(unpinPageWithMode(bm, h, PIN_SHARED));
+
+    // threads on one hot page
+    CHECK(pinPageWithMode(bm, h, 0, PIN_EXCLUSIVE));
+    memcpy(h->data + 64, counters, sizeof(counters));
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPageWithMode(bm, h, PIN_EXCLUSIVE));
+    for (i = 0; i < numThreads; i++)
+    {
+        work[i].bm = bm;
+        work[i].writer = i % 2 == 0;
+        work[i].numOps = numOps;
+        ASSERT_TRUE(pthread_create(&threads[i], NULL, useLatchedPage, &work[i]) == 0, "start a thread");
+    }
+    for (i = 0; i < numThreads; i++)
+        pthread_join(threads[i], NULL);
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(pinPage(bm, h, 0));
+    memcpy(counters, h->data + 64, sizeof(counters));
+    ASSERT_EQUALS_INT(numThreads / 2 * numOps, counters[0], "no update of a writer is lost");
+    ASSERT_EQUALS_INT(counters[0], counters[1], "both counters are updated");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    free(other);
+    TEST_DONE();
+}
+
+// readers of testOptimisticReads check page 0 without pinning it
+static void *
+readOptimistically (void *arg)
+{
+    LatchWork *work = (LatchWork *) arg;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    unsigned int version;
+    int counters[2];
+    int i;
+
+    h->data = NULL;
+    for (i = 0; i < work->numOps; i++)
+    {
+        CHECK(beginOptimisticRead(work->bm, h, 0, &version));
+        memcpy(counters, h->data + 64, sizeof(counters));
+        if (validateOptimisticRead(work->bm, h, version) == RC_OK && counters[0] != counters[1])
+            ASSERT_EQUALS_INT(counters[0], counters[1], "a validated read never sees a half updated page");
+    }
+    free(h);
+    return NULL;
+}
+
+// reads validated by page versions
+void
+testOptimisticReads (void)
+{
+    const int numThreads = 4;
+    const int numOps = 2000;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *writer = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    pthread_t threads[4];
+    LatchWork work[4];
+    unsigned int version;
+    int counters[2] = {0, 0};
+    int i;
+    testName = "Testing optimistic reads";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10, NULL);
+
+    memset(&options, 0, sizeof(options));
+    options.latchPartitions = 4;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+
+    h->data = NULL;
+    ASSERT_EQUALS_INT(RC_NON_EXISTING_PAGE_IN_FRAME, beginOptimisticRead(bm, h, 1, &version), "only pages in the pool are read optimistically");
+    CHECK(pinPage(bm, writer, 1));
+    CHECK(unpinPage(bm, writer));
+
+    // an unpinned page is read without a pin
+    CHECK(beginOptimisticRead(bm, h, 1, &version));
+    ASSERT_EQUALS_STRING("Page-1", h->data, "optimistic read of page 1");
+    CHECK(validateOptimisticRead(bm, h, version));
+    ASSERT_EQUALS_POOL("[1 0],[-1 0],[-1 0]", bm, "the reader did not pin the page");
+
+    // a writer invalidates it
+    CHECK(pinPageWithMode(bm, writer, 1, PIN_EXCLUSIVE));
+    ASSERT_EQUALS_INT(RC_READ_CONFLICT, validateOptimisticRead(bm, h, version), "a writer latched the page");
+    CHECK(unpinPageWithMode(bm, writer, PIN_EXCLUSIVE));
+    ASSERT_EQUALS_INT(RC_READ_CONFLICT, validateOptimisticRead(bm, h, version), "the page was changed");
+    CHECK(beginOptimisticRead(bm, h, 1, &version));
+    CHECK(validateOptimisticRead(bm, h, version));
+
+    // and so does evicting the page
+    for (i = 2; i < 5; i++)
+    {
+        CHECK(pinPage(bm, writer, i));
+        CHECK(unpinPage(bm, writer));
+    }
+    ASSERT_EQUALS_INT(RC_READ_CONFLICT, validateOptimisticRead(bm, h, version), "the frame holds another page");
+    ASSERT_EQUALS_INT(RC_NON_EXISTING_PAGE_IN_FRAME, beginOptimisticRead(bm, h, 1, &version), "page 1 was evicted");
+    ASSERT_EQUALS_INT(RC_NON_EXISTING_PAGE_IN_FRAME, validateOptimisticRead(bm, &((BM_PageHandle) {.pageNum = 1, .data = NULL, .frame = -1}), version),
+                      "a handle without a frame");
+    ASSERT_EQUALS_INT(RC_NON_EXISTING_PAGE_IN_FRAME, validateOptimisticRead(bm, &((BM_PageHandle) {.pageNum = 1, .data = (char *) counters, .frame = -1}), version),
+                      "a handle outside the pool");
+
+    // writers latch page 0, readers do not
+    CHECK(pinPageWithMode(bm, writer, 0, PIN_EXCLUSIVE));
+    memcpy(writer->data + 64, counters, sizeof(counters));
+    CHECK(markDirty(bm, writer));
+    CHECK(unpinPageWithMode(bm, writer, PIN_EXCLUSIVE));
+    for (i = 0; i < numThreads; i++)
+    {
+        work[i].bm = bm;
+        work[i].writer = i % 2 == 0;
+        work[i].numOps = numOps;
+        ASSERT_TRUE(pthread_create(&threads[i], NULL, work[i].writer ? useLatchedPage : readOptimistically, &work[i]) == 0, "start a thread");
+    }
+    for (i = 0; i < numThreads; i++)
+        pthread_join(threads[i], NULL);
+
+    CHECK(beginOptimisticRead(bm, h, 0, &version));
+    memcpy(counters, h->data + 64, sizeof(counters));
+    CHECK(validateOptimisticRead(bm, h, version));
+    ASSERT_EQUALS_INT(numThreads / 2 * numOps, counters[0], "no update of a writer is lost");
+    ASSERT_EQUALS_INT(counters[0], counters[1], "both counters are updated");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    free(writer);
+    TEST_DONE();
+}
+
+// the background writer cleans the next victims, so misses do not write
+void
+testBackgroundWriter (void)
+{
+    const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+    const int numStrategies = 7;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    BM_WriterStats stats;
+    int s, i, waited;
+    testName = "Testing the background writer";
+
+    for (s = 0; s < numStrategies; s++)
+    {
+        CHECK(createPageFile("testbuffer.bin"));
+        memset(&options, 0, sizeof(options));
+        options.cleanPercent = 50;
+        options.writerIntervalMs = 1;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, strategies[s], NULL, &options));
+
+        // fill the pool with dirty pages
+        for (i = 0; i < 10; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            sprintf(h->data, "%s-%i", "Page", h->pageNum);
+            CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+
+        // the writer cleans the five frames evicted next
+        for (waited = 0; waited < 2000; waited++)
+        {
+            CHECK(getWriterStats(bm, &stats));
+            if (stats.pagesWritten >= 5)
+                break;
+            usleep(1000);
+        }
+        ASSERT_EQUALS_INT(5, stats.pagesWritten, "the writer keeps half of the pool clean");
+        ASSERT_TRUE(stats.rounds > 0 && stats.maxQueueLength > 0 && stats.maxQueueLength <= 5, "it found at most five dirty candidates at a time");
+        ASSERT_TRUE(stats.pagesPerSecond > 0, "writer rate");
+        ASSERT_EQUALS_INT(5, getNumWriteIO(bm), "only the writer wrote");
+
+        // so five misses only read
+        for (i = 10; i < 15; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            sprintf(h->data, "%s-%i", "Page", h->pageNum);
+            CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+        CHECK(getWriterStats(bm, &stats));
+        ASSERT_EQUALS_INT(0, stats.dirtyEvictions, "no miss wrote a dirty victim");
+        CHECK(shutdownBufferPool(bm));
+
+        checkDummyPages(bm, 15, NULL);
+        CHECK(destroyPageFile("testbuffer.bin"));
+    }
+
+    // without a writer misses write their dirty victims
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(getWriterStats(bm, &stats));
+    ASSERT_EQUALS_INT(2, stats.dirtyEvictions, "two misses wrote their victims");
+    ASSERT_EQUALS_INT(0, stats.pagesWritten, "there is no writer");
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a thread of testPrefetch scans the file from its own start page, four pages ahead
+static void *
+scanWithPrefetch (void *arg)
+{
+    ConcurrentWork *work = (ConcurrentWork *) arg;
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char expected[64];
+    PageNumber ahead[4];
+    int i, j;
+
+    for (i = 0; i < work->numOps; i++)
+    {
+        int pageNum = (work->seed + i) % work->numPages;
+
+        if (i % 4 == 0)
+        {
+            for (j = 0; j < 4; j++)
+                ahead[j] = (pageNum + 4 + j) % work->numPages;
+            CHECK(prefetchPages(work->bm, ahead, 4));
+        }
+        CHECK(pinPage(work->bm, h, pageNum));
+        sprintf(expected, "%s-%i", "Page", pageNum);
+        if (strcmp(expected, h->data) != 0)
+            ASSERT_EQUALS_STRING(expected, h->data, "a prefetched page has its content");
+        CHECK(unpinPage(work->bm, h));
+    }
+    free(h);
+    return NULL;
+}
+
+// prefetched pages are hits for later pins
+void
+testPrefetch (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *pinned[5];
+    BM_PoolOptions options;
+    BM_PrefetchStats stats;
+    PageNumber pages[] = {0, 1, 2};
+    PageNumber mixed[] = {0, 3, 300};
+    PageNumber more[] = {4, 5};
+    pthread_t threads[4];
+    ConcurrentWork work[4];
+    char expected[64];
+    int *fixCounts;
+    int i;
+    testName = "Testing prefetching pages";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 200, NULL);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_FIFO, NULL));
+
+    // reads are started but nothing is pinned
+    CHECK(prefetchPages(bm, pages, 3));
+    CHECK(getPrefetchStats(bm, &stats));
+    ASSERT_EQUALS_INT(3, stats.issued, "three reads started");
+    fixCounts = getFixCounts(bm);
+    for (i = 0; i < 5; i++)
+        ASSERT_EQUALS_INT(0, fixCounts[i], "a prefetched page is not pinned before its first pin");
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "prefetched page content");
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[-1 0],[-1 0]", bm, "pages prefetched into the first frames");
+    ASSERT_EQUALS_INT(3, getNumReadIO(bm), "pins of prefetched pages do not read");
+    CHECK(getPrefetchStats(bm, &stats));
+    ASSERT_EQUALS_INT(3, stats.used, "three prefetched pages used");
+
+    // pages in the pool or past the end of the file are skipped
+    CHECK(prefetchPages(bm, mixed, 3));
+    CHECK(prefetchPages(bm, more, 2));
+    CHECK(getPrefetchStats(bm, &stats));
+    ASSERT_EQUALS_INT(8, stats.requested, "eight pages asked for");
+    ASSERT_EQUALS_INT(2, stats.skipped, "page 0 is in the pool, page 300 is past the end");
+
+    // prefetched pages evicted before a pin are unused
+    for (i = 0; i < 5; i++)
+    {
+        pinned[i] = MAKE_PAGE_HANDLE();
+        CHECK(pinPage(bm, pinned[i], 10 + i));
+    }
+    ASSERT_EQUALS_POOL("[14 1],[10 1],[11 1],[12 1],[13 1]", bm, "the pool is full of pinned pages");
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(unpinPage(bm, pinned[i]));
+        free(pinned[i]);
+    }
+    CHECK(getPrefetchStats(bm, &stats));
+    ASSERT_EQUALS_INT(6, stats.completed, "six reads done");
+    ASSERT_EQUALS_INT(3, stats.unused, "pages 3, 4 and 5 were evicted unused");
+    ASSERT_EQUALS_INT(0, stats.inFlight, "no read is outstanding");
+    CHECK(shutdownBufferPool(bm));
+
+    // threads scanning with prefetch share a pool
+    memset(&options, 0, sizeof(options));
+    options.latchPartitions = 4;
+    options.prefetchDepth = 8;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 16, RS_CLOCK, NULL, &options));
+    for (i = 0; i < 4; i++)
+    {
+        work[i].bm = bm;
+        work[i].seed = i * 50;
+        work[i].numOps = 1000;
+        work[i].numPages = 200;
+        ASSERT_TRUE(pthread_create(&threads[i], NULL, scanWithPrefetch, &work[i]) == 0, "start a thread");
+    }
+    for (i = 0; i < 4; i++)
+        pthread_join(threads[i], NULL);
+    CHECK(getPrefetchStats(bm, &stats));
+    ASSERT_TRUE(stats.used > 0, "the scans used prefetched pages");
+    ASSERT_EQUALS_INT(stats.issued, stats.completed + stats.inFlight, "every read is done or outstanding");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// scans recycle a ring of frames and leave the other pages of the pool alone
+void
+testScanRing (void)
+{
+    const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+    const int numStrategies = 7;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    BM_ScanRing *ring;
+    int s, i;
+    testName = "Testing scans on a ring of frames";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 200, NULL);
+
+    for (s = 0; s < numStrategies; s++)
+    {
+        CHECK(initBufferPool(bm, "testbuffer.bin", 10, strategies[s], NULL));
+        for (i = 0; i < 5; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+
+        // a ring of a 10 frame pool has 2 frames
+        CHECK(initScanRing(bm, 4, &ring));
+        for (i = 100; i < 200; i++)
+        {
+            CHECK(pinPageWithRing(bm, ring, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+        CHECK(freeScanRing(ring));
+        ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4 0],[198 0],[199 0],[-1 0],[-1 0],[-1 0]", bm, "the scan used two frames");
+        for (i = 0; i < 5; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+        ASSERT_EQUALS_INT(105, getNumReadIO(bm), "the pages before the scan are still there");
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    // the pool finds scans by itself
+    memset(&options, 0, sizeof(options));
+    options.scanThreshold = 3;
+    options.scanRingSize = 2;
+    CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, RS_LRU, NULL, &options));
+    for (i = 0; i < 10; i += 2)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    for (i = 100; i < 200; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[2 0],[4 0],[6 0],[8 0],[100 0],[101 0],[102 0],[199 0],[198 0]", bm,
+                       "after three misses the scan went to the ring");
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// the pins held on all frames of a pool
+static int
+countPins(BM_BufferPool *bm)
+{
+    int *fixCounts = getFixCounts(bm);
+    int i, pins = 0;
+
+    for (i = 0; i < bm->numPages; i++)
+        pins += fixCounts[i];
+    return pins;
+}
+
+// pinPages pins hits, misses and repeated pages of one batch, or none of them
+void
+testPinPages (void)
+{
+    const ReplacementStrategy strategies[] = {RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q};
+    const int numStrategies = 7;
+    const PageNumber batch[] = {5, 1, 3, 4, 1, 9, 0, 7, 8};
+    const int batchSize = 9;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle handles[11];
+    PageNumber pageNums[11];
+    BM_PoolOptions options;
+    char expected[64];
+    int s, i;
+    testName = "Testing batched pins";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 20, NULL);
+
+    memset(&options, 0, sizeof(options));
+    for (s = 0; s < 2 * numStrategies; s++)
+    {
+        // each strategy with one thread and shared by threads
+        options.latchPartitions = s < numStrategies ? 0 : 4;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 10, strategies[s % numStrategies], NULL, &options));
+        for (i = 0; i < 3; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+
+        CHECK(pinPages(bm, handles, batch, batchSize));
+        for (i = 0; i < batchSize; i++)
+        {
+            sprintf(expected, "%s-%i", "Page", batch[i]);
+            if (handles[i].pageNum != batch[i] || strcmp(expected, handles[i].data) != 0)
+                ASSERT_EQUALS_STRING(expected, handles[i].data, "every handle holds its page");
+        }
+        ASSERT_EQUALS_INT(9, getNumReadIO(bm), "pages 0 and 1 were hits");
+        ASSERT_EQUALS_INT(batchSize, countPins(bm), "one pin per handle");
+
+        CHECK(unpinPages(bm, handles, batchSize));
+        ASSERT_EQUALS_INT(0, countPins(bm), "all unpinned");
+
+        // eleven pages do not fit in ten frames
+        for (i = 0; i < 11; i++)
+            pageNums[i] = 10 - i;
+        ASSERT_ERROR(pinPages(bm, handles, pageNums, 11), "batch larger than the pool");
+        ASSERT_EQUALS_INT(0, countPins(bm), "a failed batch pins nothing");
+
+        pageNums[0] = -1;
+        ASSERT_ERROR(pinPages(bm, handles, pageNums, 2), "negative page number");
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    // misses past the end of the file extend it
+    CHECK(initBufferPool(bm, "testbuffer.bin", 10, RS_LRU, NULL));
+    for (i = 0; i < 5; i++)
+        pageNums[i] = 24 - i;
+    CHECK(pinPages(bm, handles, pageNums, 5));
+    ASSERT_EQUALS_POOL("[20 1],[21 1],[22 1],[23 1],[24 1],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0]", bm,
+                       "the misses were loaded in page order");
+    CHECK(unpinPages(bm, handles, 5));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// forceFlushPool writes every dirty page once, whatever the frame order,
+// with one thread or several
+void
+testFlushPool (void)
+{
+    const PageNumber order[] = {17, 3, 4, 90, 5, 16, 2, 6, 40, 41, 1, 7, 15};
+    const int numPages = 13;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    char expected[64];
+    bool *dirty;
+    int t, i;
+    testName = "Testing sorted and coalesced pool flushes";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100, NULL);
+
+    memset(&options, 0, sizeof(options));
+    for (t = 0; t < 2; t++)
+    {
+        options.flushThreads = t == 0 ? 0 : 3;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 20, RS_LRU, NULL, &options));
+        for (i = 0; i < numPages; i++)
+        {
+            CHECK(pinPage(bm, h, order[i]));
+            sprintf(h->data, "%s-%i-%i", "Flushed", order[i], t);
+            CHECK(markDirty(bm, h));
+            // the last page stays pinned
+            if (i < numPages - 1)
+                CHECK(unpinPage(bm, h));
+        }
+        *pinned = *h;
+        // clean pages are not written
+        CHECK(pinPage(bm, h, 50));
+        CHECK(unpinPage(bm, h));
+
+        CHECK(forceFlushPool(bm));
+        ASSERT_EQUALS_INT(numPages, getNumWriteIO(bm), "every dirty page written once");
+        dirty = getDirtyFlags(bm);
+        for (i = 0; i < 20; i++)
+            if (dirty[i])
+                ASSERT_TRUE(!dirty[i], "no page is dirty after the flush");
+        ASSERT_EQUALS_INT(1, countPins(bm), "the flush left the pins alone");
+        CHECK(forceFlushPool(bm));
+        ASSERT_EQUALS_INT(numPages, getNumWriteIO(bm), "a clean pool writes nothing");
+
+        CHECK(unpinPage(bm, pinned));
+        CHECK(shutdownBufferPool(bm));
+
+        CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+        for (i = 0; i < numPages; i++)
+        {
+            CHECK(pinPage(bm, h, order[i]));
+            sprintf(expected, "%s-%i-%i", "Flushed", order[i], t);
+            ASSERT_EQUALS_STRING(expected, h->data, "the flushed page is on disk");
+            CHECK(unpinPage(bm, h));
+        }
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    free(pinned);
+    TEST_DONE();
+}
+
+// whether a page is dirty in the pool
+static bool
+pageDirty(BM_BufferPool *bm, PageNumber pageNum)
+{
+    PageNumber *frameContents = getFrameContents(bm);
+    bool *dirty = getDirtyFlags(bm);
+    int i;
+
+    for (i = 0; i < bm->numPages; i++)
+        if (frameContents[i] == pageNum)
+            return dirty[i];
+    return FALSE;
+}
+
+// the dirty list counts the dirty pages and flushOldestPages writes the ones
+// dirtied first
+void
+testDirtyList (void)
+{
+    const PageNumber order[] = {5, 2, 8, 1};
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PoolOptions options;
+    BM_DirtyStats stats;
+    int p, i;
+    testName = "Testing the dirty page list";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 20, NULL);
+
+    memset(&options, 0, sizeof(options));
+    for (p = 0; p < 2; p++)
+    {
+        options.latchPartitions = p == 0 ? 0 : 4;
+        CHECK(initBufferPoolWithOptions(bm, "testbuffer.bin", 5, RS_FIFO, NULL, &options));
+        CHECK(getDirtyStats(bm, &stats));
+        ASSERT_EQUALS_INT(0, stats.dirtyPages, "a new pool is clean");
+        ASSERT_TRUE(stats.oldestDirtyMs == 0, "no dirty page has an age");
+
+        for (i = 0; i < 4; i++)
+        {
+            CHECK(pinPage(bm, h, order[i]));
+            CHECK(markDirty(bm, h));
+            // marking it again changes nothing
+            CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+        usleep(20000);
+        CHECK(getDirtyStats(bm, &stats));
+        ASSERT_EQUALS_INT(4, stats.dirtyPages, "four dirty pages");
+        ASSERT_TRUE(stats.oldestDirtyMs >= 20, "the oldest one has been dirty for the sleep");
+
+        CHECK(flushOldestPages(bm, 2));
+        ASSERT_EQUALS_INT(2, getNumWriteIO(bm), "two pages written");
+        ASSERT_TRUE(!pageDirty(bm, 5) && !pageDirty(bm, 2), "the two dirtied first are clean");
+        ASSERT_TRUE(pageDirty(bm, 8) && pageDirty(bm, 1), "the others are still dirty");
+
+        // page 5 dirty again is now the newest
+        CHECK(pinPage(bm, h, 5));
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+        CHECK(flushOldestPages(bm, 1));
+        ASSERT_TRUE(!pageDirty(bm, 8) && pageDirty(bm, 1) && pageDirty(bm, 5), "page 8 was the oldest");
+        CHECK(getDirtyStats(bm, &stats));
+        ASSERT_EQUALS_INT(2, stats.dirtyPages, "pages 1 and 5 dirty");
+
+        // the dirty pages evicted are written and leave the list
+        for (i = 10; i < 15; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+        ASSERT_EQUALS_INT(5, getNumWriteIO(bm), "the evictions wrote pages 1 and 5");
+        CHECK(getDirtyStats(bm, &stats));
+        ASSERT_EQUALS_INT(0, stats.dirtyPages, "nothing is dirty after the evictions");
+
+        CHECK(pinPage(bm, h, 12));
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+        CHECK(forceFlushPool(bm));
+        CHECK(getDirtyStats(bm, &stats));
+        ASSERT_EQUALS_INT(0, stats.dirtyPages, "nothing is dirty after a flush");
+        ASSERT_EQUALS_INT(6, getNumWriteIO(bm), "the flush wrote page 12");
+        CHECK(shutdownBufferPool(bm));
+    }
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// handles go straight to the frame of their page, stale handles look it up
+void
+testPageHandles (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle stale, other;
+    PageNumber *frameContents;
+    int i;
+    testName = "Testing frame indexed page handles";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 20, NULL);
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(pinPage(bm, h, 4));
+    frameContents = getFrameContents(bm);
+    ASSERT_TRUE(h->frame >= 0 && h->frame < 3 && frameContents[h->frame] == 4, "the handle knows the frame of its page");
+    stale = *h;
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+
+    // page 4 is evicted and loaded again into another frame
+    for (i = 5; i < 8; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "page 4 was written when it was evicted");
+    ASSERT_ERROR(markDirty(bm, &stale), "page 4 is not in the pool, its old frame holds another page");
+    CHECK(pinPage(bm, h, 6));
+    CHECK(pinPage(bm, &other, 4));
+    ASSERT_TRUE(other.frame != stale.frame, "page 4 came back into another frame");
+    ASSERT_EQUALS_POOL("[7 0],[4 1],[6 1]", bm, "pages 6 and 4 pinned");
+
+    // a stale handle of the page finds its new frame
+    CHECK(markDirty(bm, &stale));
+    ASSERT_EQUALS_POOL("[7 0],[4x1],[6 1]", bm, "the stale handle marked page 4 dirty");
+    stale.frame = 12345;
+    CHECK(forcePage(bm, &stale));
+    ASSERT_EQUALS_POOL("[7 0],[4 1],[6 1]", bm, "a handle with a frame out of range wrote page 4");
+    CHECK(unpinPage(bm, &stale));
+    ASSERT_EQUALS_POOL("[7 0],[4 0],[6 1]", bm, "and unpinned it");
+    ASSERT_ERROR(unpinPage(bm, &other), "page 4 is unpinned already");
+
+    // a handle of the page which now holds the frame of another one
+    other = *h;
+    other.pageNum = 7;
+    CHECK(pinPage(bm, &stale, 7));
+    CHECK(unpinPage(bm, &other));
+    ASSERT_EQUALS_POOL("[7 0],[4 0],[6 1]", bm, "the handle unpinned page 7, not the page of its frame");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(destroyPageFile("testbuffer.bin"));
+    free(bm);
+    free(h);
+    TEST_DONE();
+}